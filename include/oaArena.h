@@ -0,0 +1,81 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAARENA_H_
+#define OAARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace oafp
+{
+    // Bump allocator that backs the table buffers of oaFileParser.  Memory is
+    // only handed back by reset(), which folds all blocks into one block of
+    // the combined size.  A parser that keeps one arena across a library
+    // therefore stops allocating once it has seen its largest file.
+    class oaArena
+    {
+    public:
+        oaArena(size_t blockSize = 64 * 1024);
+        ~oaArena();
+
+        // Both throw std::bad_alloc if the request does not fit in a size_t.
+        void *allocate(size_t size, size_t align = 8);
+        template<typename T>
+        T *allocate(size_t num) {
+            if(num>(size_t)-1 / sizeof(T)) {
+                throw std::bad_alloc();
+            }
+
+            return (T *)allocate(sizeof(T) * num, alignof(T));
+        };
+
+        // Everything allocated after mark() is released by rewind().
+        size_t mark() const;
+        void rewind(size_t mark);
+        void reset();
+
+        size_t capacity() const;
+        size_t used() const;
+
+    private:
+        oaArena(const oaArena &);
+        oaArena &operator=(const oaArena &);
+
+        struct block {
+            char           *data;
+            size_t          size;
+        };
+
+        std::vector<block>  blocks;
+        size_t              blockSize;
+        size_t              current;    // Index of the block being filled.
+        size_t              offset;     // Bytes used in the current block.
+        size_t              before;     // Bytes in the blocks before it.
+    };
+
+} // End namespace oafp
+
+#endif //OAARENA_H_
@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAASYNCIO_H_
+#define OAASYNCIO_H_
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace oafp
+{
+    // One positional read.  result is the number of bytes read once the
+    // read completes, which is only short of len at the end of the file, or
+    // a negative errno.
+    struct asyncRead {
+        int                 fd;
+        unsigned long       offset;
+        char               *buffer;
+        unsigned long       len;
+        unsigned long       tag;            // Free for the caller.
+        long                result;
+    };
+
+    // Keeps up to depth positional reads in flight at once.  Reads go
+    // through an io_uring when the kernel offers one and through a pool of
+    // pread threads otherwise.  Short reads are resumed internally, so a
+    // read completes only once it is whole, at the end of the file or on
+    // an error.  Not thread safe; reads are queued and collected by one
+    // thread.
+    class oaAsyncIO
+    {
+    public:
+        oaAsyncIO(unsigned int depth = 64, bool useRing = true);
+        ~oaAsyncIO();
+
+        // True if reads go through an io_uring.
+        bool isRing() const;
+
+        // Queues a read; it is submitted by the next complete() call.
+        void read(int fd, unsigned long offset, char *buffer, unsigned long len,
+                  unsigned long tag);
+
+        // Submits the queued reads and waits until at least one read has
+        // completed.  Appends the completed reads to done and returns how
+        // many it appended, 0 if no read was outstanding.
+        size_t complete(std::vector<asyncRead> &done);
+
+        // Reads queued or in flight.
+        size_t outstanding() const;
+
+    private:
+        oaAsyncIO(const oaAsyncIO &);
+        oaAsyncIO &operator=(const oaAsyncIO &);
+
+        class ring;
+        class pool;
+
+        unsigned int            depth;
+        std::deque<asyncRead>   queued;
+        size_t                  inFlight;
+        ring                   *uring;
+        pool                   *threads;
+    };
+
+} // End namespace oafp
+
+#endif //OAASYNCIO_H_
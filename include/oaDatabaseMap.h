@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OADATABASEMAP_H_
+#define OADATABASEMAP_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace oafp
+{
+    // The database map (0x07) merged with its delta (0x1f) as parallel
+    // arrays sorted by id.  Both sections of the map are kept in one index;
+    // isDataTable() tells the data table entries, which include every delta
+    // entry, from the others.  A delta entry replaces a map entry with the
+    // same id, whichever of the two tables is seen first.  id to type
+    // lookups are a binary search over ids(); type to ids lookups use a
+    // second copy sorted by type, which is built by the first findIds(), so
+    // that call must not race with other lookups.
+    class oaDatabaseMap
+    {
+    public:
+        oaDatabaseMap();
+
+        void assign(const unsigned long ids[], const unsigned int types[],
+                    unsigned int idCount, const unsigned long tblIds[],
+                    const unsigned int tblTypes[], unsigned int tblCount);
+        void applyDelta(const unsigned long ids[], const unsigned int types[],
+                        unsigned long num);
+        // assign() in pieces, for maps delivered in chunks: the map entries
+        // are replaced by the pieces passed between startMap() and
+        // finishMap().
+        void startMap();
+        void appendMap(const unsigned long ids[], const unsigned int types[],
+                       unsigned long num, bool dataTable);
+        void finishMap();
+        void clear();
+
+        unsigned int count() const;
+        const unsigned long *ids() const;
+        const unsigned int *types() const;
+        bool isDataTable(unsigned int i) const;
+
+        // Position of id in ids(), or -1 if it is not mapped.
+        int find(unsigned long id) const;
+        // Type of id, or false if it is not mapped.
+        bool findType(unsigned long id, unsigned int &type) const;
+        // Points ids at the sorted ids of the given type and returns their
+        // number.  The array is valid until the map changes.
+        unsigned int findIds(unsigned int type, const unsigned long *&ids) const;
+
+    private:
+        struct entry {
+            unsigned long   id;
+            unsigned int    type;
+            unsigned int    dataTable;
+        };
+
+        void add(std::vector<entry> &to, const unsigned long ids[],
+                 const unsigned int types[], unsigned long num, unsigned int dataTable);
+        void merge();
+        void indexTypes() const;
+
+        std::vector<unsigned long>  idColumn;
+        std::vector<unsigned int>   typeColumn;
+        std::vector<unsigned char>  dataTableColumn;
+        std::vector<entry>          base;
+        std::vector<entry>          delta;
+        std::vector<entry>          merged;
+        mutable std::vector<unsigned int>   byTypeTypes;
+        mutable std::vector<unsigned long>  byTypeIds;
+        mutable bool                        typesIndexed;
+    };
+
+} // End namespace oafp
+
+#endif //OADATABASEMAP_H_
@@ -0,0 +1,358 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Changes:
+ * 2017-01-01: First & Last Name: What you did.
+ * 2017-05-28: Kevin Nesmith: Initial contribution.
+ *
+ */
+
+#ifndef OAFILEPARSER_H_
+#define OAFILEPARSER_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "oaArena.h"
+
+namespace oafp
+{
+    // Make sure the structs are kept to a 4 byte alignment.
+    // If need be, add fields at the end to fullfill this requirement.
+    struct fileHeader {
+        unsigned int        testBit;        // 4 bytes
+        unsigned short      type;           // 2 bytes - short 2
+        unsigned short      schema;         // 2 bytes - back to even
+        unsigned long       offset;         // 8 bytes
+        unsigned int        size;           // 4 bytes
+        unsigned int        used;           // 4 bytes
+    };
+
+    struct tableIndex {
+        unsigned int        size;           // 4 bytes
+        unsigned int        used;           // 4 bytes
+        unsigned int        deleted;        // 4 bytes
+        unsigned int        first;          // 4 bytes
+    };
+
+    struct appInfo {
+        unsigned short appDataModelRev;     // 2 bytes - short 2
+        unsigned short kitDataModelRev;     // 2 bytes - back to even
+        unsigned short appAPIMinorRev;      // 2 bytes - short 2
+        unsigned short kitReleaseNum;       // 2 bytes - back to even
+    };
+
+    class oaAsyncIO;
+    struct asyncRead;
+    class oaDatabaseMap;
+    class oaParseCache;
+    class oaParseStats;
+    class oaStringTable;
+
+    // A run of data tables, the tables that hold the design objects the
+    // database map points to, as parallel arrays.  data[i] holds the
+    // sizes[i] raw bytes of table ids[i]; types[i] is its type from the
+    // database map, or unknownType if the map does not list it.
+    struct dataTableBatch {
+        static const unsigned int unknownType = 0xffffffff;
+
+        unsigned int            num;
+        const unsigned long    *ids;
+        const unsigned int     *types;
+        const unsigned long    *sizes;
+        const char *const      *data;
+        unsigned long           bytes;          // Sum of sizes.
+    };
+
+    // A read-only mapping of a single table, from tableDirectory::map().
+    struct tableMapping {
+        const char         *data;           // First byte of the table.
+        unsigned long       size;
+        void               *addr;           // Page aligned start.
+        unsigned long       length;
+    };
+
+    // Sequential source of file bytes for oaFileParser::parseStream().
+    // read() returns the number of bytes read, 0 at the end of the input
+    // and a negative value on error.
+    class oaReader
+    {
+    public:
+        virtual ~oaReader() {};
+        virtual long read(void *buffer, unsigned long len) = 0;
+    };
+
+    // Reads from a file descriptor, e.g. a pipe or an archive member.
+    class oaFdReader : public oaReader
+    {
+    public:
+        oaFdReader(int fd);
+        virtual long read(void *buffer, unsigned long len);
+
+    private:
+        int                 fd;
+    };
+
+    // The file header and table index of one file, read without decoding
+    // any of the tables.  The file stays open so single tables can be
+    // fetched later through oaFileParser::parseTable().
+    class tableDirectory
+    {
+    public:
+        tableDirectory();
+        ~tableDirectory();
+
+        // Returns 0 once the header and index are read, -1 if the file
+        // cannot be opened or read and 1 if they run past its end.
+        int open(const char *filePath);
+        void close();
+
+        // Index of the table with the given id, or -1 if there is none.
+        int find(unsigned long id) const;
+        // Absolute file position of table i.
+        unsigned long position(unsigned int i) const;
+        // Reads the sizes[i] bytes of table i; returns 0 on success.
+        int read(unsigned int i, char *buffer) const;
+        // Reads len bytes from offset within table i; returns 0 on success.
+        int read(unsigned int i, unsigned long offset, char *buffer,
+                 unsigned long len) const;
+        // Maps only the pages of table i; returns 0 on success.  The
+        // mapping outlives the directory and is released with unmap().
+        int map(unsigned int i, tableMapping &mapping) const;
+        static void unmap(tableMapping &mapping);
+
+        fileHeader          header;
+        unsigned long      *ids;
+        unsigned long      *offsets;
+        unsigned long      *sizes;
+        unsigned long       startOffset;
+        unsigned long       fileSize;
+
+    private:
+        tableDirectory(const tableDirectory &);
+        tableDirectory &operator=(const tableDirectory &);
+
+        int                         fd;
+        std::vector<unsigned long>  index;
+    };
+
+    class oaFileParser
+    {
+    public:
+        oaFileParser();
+        virtual ~oaFileParser();
+
+        int parse(const char *filePath);
+
+        // Maps the whole file once and hands the callbacks pointers straight
+        // into the mapping instead of copying each table.  The mapping is
+        // private, so callbacks may still write to the arrays they receive,
+        // and it stays valid until the next parseMapped() call or until the
+        // parser is destroyed.
+        int parseMapped(const char *filePath);
+
+        // Reads the tables on numThreads threads (0 for one per core) with
+        // positional reads, a bounded number of tables ahead of the
+        // callbacks, which still run on the calling thread in the same
+        // order as with parse().  Meant for single very large files.
+        int parseParallel(const char *filePath, unsigned int numThreads = 0);
+
+        // Parses many files on the calling thread while keeping up to
+        // queueDepth reads in flight through oaAsyncIO: the headers of a
+        // window of files are read at once, then the index of each file and
+        // then all of its tables in one batch.  Files are delivered in the
+        // order given, each between onParsedFileBegin() and
+        // onParsedFileEnd(), with the same callbacks as parse() apart from
+        // the buffer budget.  Returns the number of files that failed.
+        int parseFiles(const std::vector<std::string> &filePaths,
+                       unsigned int queueDepth = 64);
+
+        // Parses in a single forward pass without seeking, for pipes and
+        // archive members.  Tables are decoded in file order rather than
+        // index order, and the gaps between them are read and dropped.
+        int parseStream(oaReader &reader);
+        int parseStream(int fd);
+
+        // Replays the callbacks recorded in cache when the file's size,
+        // mtime and inode still match, and parses and records it otherwise.
+        int parseCached(const char *filePath, oaParseCache &cache);
+
+        // Reads only the file header and the table index.  Single tables can
+        // then be decoded on demand with parseTable(), which fires just the
+        // callback of that table.  parseTable() returns 1 if the directory
+        // has no decodable table with that id.
+        int readDirectory(const char *filePath, tableDirectory &dir);
+        int parseTable(const tableDirectory &dir, unsigned long id);
+
+        // Table buffers come from the parser's own arena unless another one
+        // is supplied here; NULL switches back to the parser's own.  The
+        // arena is reset at the start of every parse, so buffers handed to
+        // the callbacks are only valid until the next parse.
+        void setArena(oaArena *arena);
+
+        // With string indexing on, string tables are delivered through
+        // onParsedStringTableIndex() as an oaStringTable instead of through
+        // onParsedStringTable().  The index is reused across parses.
+        void setIndexStrings(bool indexStrings);
+
+        // With data tables on, every table that is neither the index nor one
+        // of the decoded metadata tables is delivered through
+        // onParsedDataTables() in batches of up to dataBatchTables tables or
+        // dataBatchBytes bytes, in file order, after the metadata tables.
+        // parseStream() delivers them as they arrive instead, so there only
+        // tables after the database map get their types.  parseCached() and
+        // parseTable() do not deliver data tables.
+        void setDataTables(bool dataTables);
+
+        // With a budget, parse() reads string tables (0x0a) and database
+        // maps (0x07) larger than the budget in pieces of at most that many
+        // bytes and delivers them through the Begin/Chunk/End callbacks
+        // instead of the usual ones, so no buffer grows past the budget.
+        // String chunks hold whole strings and start at offset bytes into
+        // the strings; map chunks hold whole entries, first those of the
+        // map and then, with dataTables set, those of the data tables.  A
+        // set database map is still filled.  0 turns the budget off; the
+        // smallest budget is minBufferBudget.
+        void setBufferBudget(unsigned long bytes);
+
+        static const unsigned long  minBufferBudget = 4096;
+
+        static const unsigned int   dataBatchTables = 1024;
+        static const unsigned long  dataBatchBytes = 4 * 1024 * 1024;
+
+        // While set, map is cleared at the start of every parse and filled
+        // from the database map and its delta before their callbacks run,
+        // so the callbacks can already query it.  NULL turns this off.
+        void setDatabaseMap(oaDatabaseMap *map);
+
+        // Collects byte, read, seek and per-table timing counters into stats
+        // for every following parse; NULL turns collection off again.
+        void setStats(oaParseStats *stats);
+
+        // parseFiles() stops opening files while the tables it holds add up
+        // to more than this, but always keeps at least one file going.
+        static const unsigned long  asyncWindowBytes = 64 * 1024 * 1024;
+
+    protected:
+        virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                     unsigned short schema, unsigned long offset,
+                                     unsigned int size, unsigned int used) = 0;
+        virtual void onParsedTableInformation(unsigned long ids[],
+                                              unsigned long offsets[],
+                                              unsigned long sizes[], unsigned int num) = 0;
+        virtual void onParsedFlags(unsigned int flags) = 0;
+        virtual void onParsedTimeStamp(unsigned int timeStamp) = 0;
+        virtual void onParsedLastSavedTime(unsigned long lastSavedTime) = 0;
+        virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                         unsigned int idCount, unsigned long tblIds[],
+                                         unsigned int tblTypes[], unsigned int tblCount) = 0;
+        virtual void onParsedStringTable(tableIndex table, const char *buffer) = 0;
+        virtual void onParsedStringTableIndex(const oaStringTable &strings) {};
+        virtual void onParsedCreateTime(unsigned long createTime) = 0;
+        virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                            const char *buildName) = 0;
+        virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                              unsigned short kitDataModelRev,
+                                              unsigned short appAPIMinorRev,
+                                              unsigned short kitReleaseNum,
+                                              const char *appBuildName,
+                                              const char *kitBuildName,
+                                              const char *platforName) = 0;
+        virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                          unsigned long num) = 0;
+        virtual void onParsedDatabaseMarker(unsigned int bitCheck) = 0;
+        virtual void onParsedError(const char *error) = 0;
+        // The batch and its buffers are only valid during the call.
+        virtual void onParsedDataTables(const dataTableBatch &batch) {};
+        virtual void onParsedStringTableBegin(const tableIndex &table) {};
+        virtual void onParsedStringTableChunk(const char *strings,
+                                              unsigned long size, unsigned long offset) {};
+        virtual void onParsedStringTableEnd() {};
+        virtual void onParsedDatabaseMapBegin(unsigned int idCount,
+                                              unsigned int tblCount) {};
+        virtual void onParsedDatabaseMapChunk(unsigned long ids[], unsigned int types[],
+                                              unsigned int num, bool dataTables) {};
+        virtual void onParsedDatabaseMapEnd() {};
+        // parseFiles() brackets the callbacks of each file with these.
+        virtual void onParsedFileBegin(const char *filePath) {};
+        virtual void onParsedFileEnd(const char *filePath, int status) {};
+
+    private:
+        friend class oaParseCache;
+
+        void releaseMapping();
+        bool isKnownTable(unsigned long id);
+        bool isDataTable(unsigned long id);
+        void readTable(unsigned long id, char *data, unsigned long tblSize);
+        void readFully(oaReader &reader, void *buffer, unsigned long len);
+        void readAt(FILE *file, unsigned long pos, void *buffer, unsigned long len);
+        void readChunked(FILE *file, unsigned long id, unsigned long pos,
+                         unsigned long tblSize);
+        void readStringTableChunked(FILE *file, unsigned long pos,
+                                    unsigned long tblSize);
+        void readDatabaseMapChunked(FILE *file, unsigned long pos,
+                                    unsigned long tblSize);
+
+        class statsScope;
+        class dataBatch;
+        class tableReader;
+        struct asyncFile;
+        double statsClock() const;
+        void statsRead(unsigned long bytes, bool seek);
+        void statsTable(unsigned long id, unsigned long bytes, double started);
+        void startFile(asyncFile &file, const char *filePath, size_t index,
+                       oaAsyncIO &io);
+        void readFile(asyncFile &file, const asyncRead &read, oaAsyncIO &io);
+        int deliverFile(asyncFile &file);
+
+        void read0x04(char *data, unsigned long tblSize);
+        void read0x05(char *data, unsigned long tblSize);
+        void read0x06(char *data, unsigned long tblSize);
+        void read0x07(char *data, unsigned long tblSize);
+        void read0x0a(char *data, unsigned long tblSize);
+        void read0x0b(char *data, unsigned long tblSize);
+        void read0x19(char *data, unsigned long tblSize);
+        void read0x1c(char *data, unsigned long tblSize);
+        void read0x1d(char *data, unsigned long tblSize);
+        void read0x1f(char *data, unsigned long tblSize);
+        void read0x28(char *data, unsigned long tblSize);
+
+        char               *mapData;
+        unsigned long       mapSize;
+        oaArena             ownArena;
+        oaArena            *arena;
+        oaStringTable      *strings;
+        oaParseStats       *stats;
+        oaDatabaseMap      *dbMap;          // userMap, else ownMap.
+        oaDatabaseMap      *userMap;
+        oaDatabaseMap      *ownMap;         // Only kept for data tables.
+        bool                dataTables;
+        unsigned long       bufferBudget;
+    };
+
+} // End namespace oafp
+
+#endif //OAFILEPARSER_H_
@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAFILEVERIFIER_H_
+#define OAFILEVERIFIER_H_
+
+#include <string>
+
+namespace oafp
+{
+    enum verifyStatus {
+        verifyOk = 0,
+        verifyUnreadable,           // The file cannot be opened or read.
+        verifyBadIndex,             // Header or table index is cut short.
+        verifyTableOutOfRange,      // A table lies outside the table area.
+        verifyTableOverlap,         // Two tables share bytes.
+        verifyBadTable              // A table's contents contradict its size.
+    };
+
+    struct verifyReport {
+        verifyStatus        status;
+        unsigned long       table;          // Offending table id.
+        unsigned long       other;          // Second table of an overlap.
+        std::string         message;
+    };
+
+    // Checks that a file can be parsed without decoding it.  The header and
+    // table index are read first, then every table extent is checked
+    // against the file size and the other tables, and last the counts of
+    // the known tables are checked against their sizes.  Only the first few
+    // bytes of the large tables are read.  Verification stops at the first
+    // problem, which is described in report.
+    verifyStatus verifyFile(const char *filePath, verifyReport &report);
+
+} // End namespace oafp
+
+#endif //OAFILEVERIFIER_H_
@@ -0,0 +1,118 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAFILEWRITER_H_
+#define OAFILEWRITER_H_
+
+#include <vector>
+
+#include <sys/uio.h>
+
+#include "oaArena.h"
+#include "oaFileParser.h"
+
+namespace oafp
+{
+    // Writes a file oaFileParser reads back.  Tables are added first and
+    // written with write() in one pass of gathered writes: the header, the
+    // table index, the tables stored relative to the 0x01 table and last
+    // the string tables (0x0a) at absolute offsets, every table 8 byte
+    // aligned.  The index lists 0x01 first and the other tables in the
+    // order they were added.
+    //
+    // Table contents are not copied.  addTable() and the arrays and
+    // strings handed to the add functions of the decoded tables are
+    // referenced until write(); only the small fixed fields are kept by
+    // the writer itself.
+    class oaFileWriter
+    {
+    public:
+        oaFileWriter();
+
+        void setHeader(unsigned int testBit, unsigned short type,
+                       unsigned short schema);
+
+        // A table written as is, e.g. a data table.
+        void addTable(unsigned long id, const void *data, unsigned long size);
+
+        // The tables the parser decodes, laid out the way it reads them.
+        void addFlags(unsigned int flags);
+        void addTimeStamp(unsigned int timeStamp);
+        void addLastSavedTime(unsigned long lastSavedTime);
+        void addDatabaseMap(const unsigned long ids[], const unsigned int types[],
+                            unsigned int idCount, const unsigned long tblIds[],
+                            const unsigned int tblTypes[], unsigned int tblCount);
+        // strings holds table.used bytes of NUL terminated strings.
+        void addStringTable(const tableIndex &table, const char *strings);
+        void addCreateTime(unsigned long createTime);
+        void addDMandBuildName(unsigned short dataModelRev, const char *buildName);
+        void addBuildInformation(unsigned short appDataModelRev,
+                                 unsigned short kitDataModelRev,
+                                 unsigned short appAPIMinorRev,
+                                 unsigned short kitReleaseNum,
+                                 const char *appBuildName,
+                                 const char *kitBuildName,
+                                 const char *platforName);
+        void addDatabaseMapD(const unsigned long ids[], const unsigned int types[],
+                             unsigned long num);
+        void addDatabaseMarker(unsigned int bitCheck);
+
+        // Both return 0 once every byte is written, 1 otherwise.  The tables
+        // stay added, so the same file can be written again.
+        int write(const char *filePath);
+        int write(int fd);
+
+        // Drops all tables to start the next file.
+        void clear();
+
+    private:
+        oaFileWriter(const oaFileWriter &);
+        oaFileWriter &operator=(const oaFileWriter &);
+
+        struct writerTable {
+            unsigned long       id;
+            unsigned long       size;
+            size_t              first;          // First piece.
+            size_t              num;            // Number of pieces.
+        };
+
+        void beginTable(unsigned long id);
+        void addPiece(const void *data, unsigned long size);
+        void addName(const char *name);
+        template<typename T>
+        void addValue(T value) {
+            T *copy = arena.allocate<T>(1);
+            *copy = value;
+            addPiece(copy, sizeof(value));
+        };
+
+        fileHeader                  header;
+        std::vector<writerTable>    tables;
+        std::vector<struct iovec>   pieces;
+        oaArena                     arena;
+    };
+
+} // End namespace oafp
+
+#endif //OAFILEWRITER_H_
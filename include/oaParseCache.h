@@ -0,0 +1,91 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAPARSECACHE_H_
+#define OAPARSECACHE_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace oafp
+{
+    class oaFileParser;
+
+    // Identity of a file on disk.  A cached entry is only replayed while all
+    // of these still match.
+    struct fileKey {
+        unsigned long       size;
+        long                mtimeSec;
+        long                mtimeNsec;
+        unsigned long       inode;
+        unsigned long       device;
+    };
+
+    // Sidecar cache of decoded callbacks, keyed on path and file identity.
+    // A miss parses the file once while recording every callback in a
+    // compact binary form; a hit replays the recorded callbacks without
+    // opening the file.  Failed parses are never cached.  The cache is safe
+    // to share between the workers of an oaLibraryScanner.
+    class oaParseCache
+    {
+    public:
+        oaParseCache();
+
+        // A missing cache file loads as an empty cache.  Both return 0 on
+        // success.
+        int load(const char *cachePath);
+        int save(const char *cachePath);
+        // Drops the entries that were neither replayed nor stored since
+        // load(), e.g. files that left the library.
+        void prune();
+
+        int parse(oaFileParser &parser, const char *filePath);
+
+        unsigned long hits() const;
+        unsigned long misses() const;
+
+    private:
+        struct entry {
+            fileKey                             key;
+            std::shared_ptr<const std::string>  records;
+            bool                                used;
+        };
+
+        bool lookup(const std::string &path, const fileKey &key,
+                    std::shared_ptr<const std::string> &records);
+        void store(const std::string &path, const fileKey &key,
+                   const std::shared_ptr<const std::string> &records);
+        int replay(oaFileParser &parser, const std::string &records);
+
+        std::unordered_map<std::string, entry>  entries;
+        std::mutex                              lock;
+        unsigned long                           numHits;
+        unsigned long                           numMisses;
+    };
+
+} // End namespace oafp
+
+#endif //OAPARSECACHE_H_
@@ -0,0 +1,96 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAPARSESTATS_H_
+#define OAPARSESTATS_H_
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace oafp
+{
+    struct parseCounters {
+        unsigned long       parses;
+        unsigned long       errors;
+        unsigned long       bytesRead;
+        unsigned long       reads;
+        unsigned long       seeks;
+        double              seconds;
+    };
+
+    // Histogram bucket b counts values in [2^b, 2^(b+1)); latencies are
+    // kept in nanoseconds, sizes in bytes.
+    struct tableStats {
+        static const int    numBuckets = 48;
+
+        unsigned long       count;
+        unsigned long       bytes;
+        double              seconds;
+        double              maxSeconds;
+        unsigned long       latency[numBuckets];
+        unsigned long       size[numBuckets];
+    };
+
+    // Counters collected by an oaFileParser that has been given a stats
+    // object with setStats().  lastParse covers the most recent parse, total
+    // and tables every parse since reset().  A parser without stats only
+    // pays for a NULL check per read and per table.
+    class oaParseStats
+    {
+    public:
+        static const unsigned int numSlowest = 10;
+
+        oaParseStats();
+
+        void reset();
+        // Adds the counters of another parser, e.g. another scan worker.
+        void merge(const oaParseStats &other);
+        // Writes all counters as one JSON object.
+        void dump(FILE *out) const;
+
+        void beginParse(const char *filePath);
+        void addRead(unsigned long bytes, bool seek);
+        void addTable(unsigned long id, unsigned long bytes, double seconds);
+        void endParse(int status);
+
+        parseCounters                               lastParse;
+        parseCounters                               total;
+        std::map<unsigned long, tableStats>         tables;
+        // The slowest parses since reset(), slowest first.
+        std::vector<std::pair<double, std::string> > slowest;
+
+    private:
+        void addSlowest(double seconds, const std::string &filePath);
+
+        std::chrono::steady_clock::time_point       start;
+        std::string                                 filePath;
+    };
+
+} // End namespace oafp
+
+#endif //OAPARSESTATS_H_
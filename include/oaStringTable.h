@@ -0,0 +1,77 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OASTRINGTABLE_H_
+#define OASTRINGTABLE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "oaFileParser.h"
+
+namespace oafp
+{
+    // Offset index and interned lookup over the NUL separated strings of a
+    // string table (0x0a).  Strings are numbered in table order and are not
+    // copied, so the index is only valid as long as the buffer it was built
+    // from.  Rebuilding an index reuses its storage.  The hash is built by
+    // the first find(), so that call must not race with other lookups.
+    class oaStringTable
+    {
+    public:
+        oaStringTable();
+
+        void build(const tableIndex &table, const char *buffer);
+        void clear();
+
+        unsigned int count() const;
+        const char *string(unsigned int id) const;
+        unsigned int length(unsigned int id) const;
+        // Byte offset of the string in the table.
+        unsigned int offset(unsigned int id) const;
+
+        // Id of the first string equal to str, or -1 if there is none.
+        int find(const char *str) const;
+        int find(const char *str, size_t len) const;
+        // Id of the string starting at the given byte offset, or -1.
+        int findOffset(unsigned int offset) const;
+
+        const tableIndex &table() const;
+        // The table.used bytes the index was built over.
+        const char *data() const;
+
+    private:
+        void indexStrings();
+        void hashStrings() const;
+
+        tableIndex                  tbl;
+        const char                 *buffer;
+        std::vector<unsigned int>   starts;     // count() + 1 entries
+        mutable std::vector<unsigned int>   slots;  // id + 1, 0 marks a free slot
+        mutable unsigned int                slotMask;
+    };
+
+} // End namespace oafp
+
+#endif //OASTRINGTABLE_H_
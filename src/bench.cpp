@@ -0,0 +1,280 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "oaFileParser.h"
+#include "oaFileVerifier.h"
+#include "oaLibraryScanner.h"
+#include "oaParseCache.h"
+
+using namespace std;
+
+typedef chrono::steady_clock benchClock;
+
+// Callback slots the time between two callbacks is charged to.  The gap in
+// front of a callback is the time it took to read and decode its table.
+enum benchSlot {
+    slotPreface, slotIndex, slot0x04, slot0x05, slot0x06, slot0x07, slot0x0a,
+    slot0x19, slot0x1c, slot0x1d, slot0x1f, slot0x28, slotData, slotCount
+};
+
+static const char *slotNames[slotCount] = {
+    "header", "index", "0x04", "0x05", "0x06", "0x07", "0x0a",
+    "0x19", "0x1c", "0x1d", "0x1f", "0x28", "data"
+};
+
+struct benchTiming {
+    double          total;
+    double          max;
+    unsigned long   count;
+};
+
+class BenchParser : public oafp::oaFileParser
+{
+public:
+    BenchParser() {
+        memset(timing, 0, sizeof(timing));
+    };
+
+    void start() {
+        last = benchClock::now();
+    };
+
+    benchTiming timing[slotCount];
+    unsigned long errors = 0;
+
+protected:
+    virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                 unsigned short schema, unsigned long offset, unsigned int size,
+                                 unsigned int used) {
+        record(slotPreface);
+    };
+    virtual void onParsedTableInformation(unsigned long ids[],
+                                          unsigned long offsets[], unsigned long sizes[], unsigned int num) {
+        record(slotIndex);
+    };
+    virtual void onParsedFlags(unsigned int flags) {
+        record(slot0x04);
+    };
+    virtual void onParsedTimeStamp(unsigned int timeStamp) {
+        record(slot0x05);
+    };
+    virtual void onParsedLastSavedTime(unsigned long lastSavedTime) {
+        record(slot0x06);
+    };
+    virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                     unsigned int idCount, unsigned long tblIds[],
+                                     unsigned int tblTypes[], unsigned int tblCount) {
+        record(slot0x07);
+    };
+    virtual void onParsedStringTable(oafp::tableIndex table, const char *buffer) {
+        record(slot0x0a);
+    };
+    virtual void onParsedCreateTime(unsigned long createTime) {
+        record(slot0x19);
+    };
+    virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                        const char *buildName) {
+        record(slot0x1c);
+    };
+    virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                          unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
+                                          unsigned short kitReleaseNum, const char *appBuildName,
+                                          const char *kitBuildName, const char *platforName) {
+        record(slot0x1d);
+    };
+    virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                      unsigned long num) {
+        record(slot0x1f);
+    };
+    virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
+        record(slot0x28);
+    };
+    virtual void onParsedError(const char *error) {
+        ++errors;
+    };
+    virtual void onParsedDataTables(const oafp::dataTableBatch &batch) {
+        record(slotData);
+    };
+
+private:
+    void record(benchSlot slot) {
+        benchClock::time_point now = benchClock::now();
+        double elapsed = chrono::duration<double>(now - last).count();
+        benchTiming &t = timing[slot];
+        t.total += elapsed;
+        t.count += 1;
+
+        if(elapsed>t.max) {
+            t.max = elapsed;
+        }
+
+        last = now;
+    };
+
+    benchClock::time_point last;
+};
+
+// Runs one parse mode over the corpus.  New parse modes only need an entry
+// here and in BENCH_MODES of the Makefile.
+static int runMode(BenchParser &parser, const string &mode, const char *path)
+{
+    if(mode=="parse") {
+        return parser.parse(path);
+    } else if(mode=="mmap") {
+        return parser.parseMapped(path);
+    } else if(mode=="parallel") {
+        return parser.parseParallel(path);
+    } else if(mode=="data") {
+        // Also delivers the data tables, in batches.
+        parser.setDataTables(true);
+        return parser.parse(path);
+    } else if(mode=="cache") {
+        // The first round fills the cache, later rounds replay it.
+        static oafp::oaParseCache cache;
+        return parser.parseCached(path, cache);
+    } else if(mode=="verify") {
+        // Only checks the structure, nothing is decoded.
+        oafp::verifyReport report;
+
+        if(oafp::verifyFile(path, report)!=oafp::verifyOk) {
+            ++parser.errors;
+        }
+
+        return 0;
+    } else if(mode=="stream") {
+        int fd = open(path, O_RDONLY);
+        int status = parser.parseStream(fd);
+        close(fd);
+        return status;
+    }
+
+    return -1;
+}
+
+
+// ****************************************************************************
+// main()
+//
+// Parses every file of a corpus a number of times with one parse mode and
+// reports throughput, per-table latency and peak RSS.
+// ****************************************************************************
+int main(int argc, char *argv[])
+{
+    string mode = "parse";
+    unsigned int rounds = 3;
+    int arg = 1;
+
+    for(; arg+1<argc && strncmp(argv[arg], "--", 2)==0; arg+=2) {
+        if(strcmp(argv[arg], "--mode")==0) {
+            mode = argv[arg+1];
+        } else if(strcmp(argv[arg], "--rounds")==0) {
+            rounds = strtoul(argv[arg+1], NULL, 0);
+        } else {
+            break;
+        }
+    }
+
+    if(arg+1!=argc) {
+        fprintf(stderr, "Usage: ./benchParser [--mode parse|mmap|stream|cache|data|parallel|\n"
+                "                       verify|async] [--rounds N] corpusDir\n");
+        return 1;
+    }
+
+    vector<string> files;
+
+    if(oafp::findLibraryFiles(argv[arg], files)!=0 || files.empty()) {
+        fprintf(stderr, "No OpenAccess files found in %s\n", argv[arg]);
+        return 1;
+    }
+
+    unsigned long bytes = 0;
+
+    for(size_t i=0; i<files.size(); ++i) {
+        struct stat st;
+
+        if(stat(files[i].c_str(), &st)==0) {
+            bytes += st.st_size;
+        }
+    }
+
+    BenchParser parser;
+    benchClock::time_point begin = benchClock::now();
+
+    for(unsigned int r=0; r<rounds; ++r) {
+        // Takes the whole corpus at once, so it has no runMode() entry.
+        if(mode=="async") {
+            parser.start();
+            parser.parseFiles(files);
+            continue;
+        }
+
+        for(size_t i=0; i<files.size(); ++i) {
+            parser.start();
+
+            if(runMode(parser, mode, files[i].c_str())<0) {
+                fprintf(stderr, "Unknown parse mode %s\n", mode.c_str());
+                return 1;
+            }
+        }
+    }
+
+    double elapsed = chrono::duration<double>(benchClock::now() - begin).count();
+    double parsed = (double)files.size() * rounds;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("mode %s: %zu files, %u rounds, %.3f s\n", mode.c_str(), files.size(),
+           rounds, elapsed);
+    printf("\tfiles/sec: %.1f\n", parsed / elapsed);
+    printf("\tMB/sec:    %.1f\n", bytes * (double)rounds / elapsed / (1024.0 * 1024.0));
+    printf("\tpeak RSS:  %ld KB\n", usage.ru_maxrss);
+    printf("\terrors:    %lu\n", parser.errors);
+    printf("\ttable    count      avg us      max us\n");
+
+    for(int s=0; s<slotCount; ++s) {
+        const benchTiming &t = parser.timing[s];
+
+        if(t.count==0) {
+            continue;
+        }
+
+        printf("\t%-6s %7lu %11.3f %11.3f\n", slotNames[s], t.count,
+               t.total / t.count * 1e6, t.max * 1e6);
+    }
+
+    return parser.errors==0 ? 0 : 1;
+}
@@ -0,0 +1,272 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "oaFileParser.h"
+#include "oaFileWriter.h"
+
+using namespace std;
+
+// ****************************************************************************
+// Synthetic OpenAccess corpus generator for the benchmarks.
+//
+// Every file carries the metadata tables the parser decodes (flags, time
+// stamps, database map and delta, build information, end marker and the
+// string table) plus a number of filler tables that stand in for the design
+// object tables.  oaFileWriter lays them out: index items relative to the
+// 0x01 table, the string table at an absolute offset, all of them 8 byte
+// aligned.
+// ****************************************************************************
+
+struct genOptions {
+    unsigned int    files;
+    unsigned int    tables;
+    unsigned int    strings;
+    unsigned int    mapEntries;
+    unsigned int    fillerSize;
+    unsigned int    seed;
+};
+
+struct genTable {
+    unsigned long   id;
+    string          data;
+};
+
+static void append(string &data, const void *value, size_t size)
+{
+    data.append((const char *)value, size);
+}
+
+template<typename T>
+static void appendValue(string &data, T value)
+{
+    append(data, &value, sizeof(value));
+}
+
+static void appendName(string &data, const char *name)
+{
+    // Names are padded the way read0x1d expects: NUL plus up to 8 bytes.
+    size_t len = strlen(name);
+    data.append(name, len);
+    data.append(8 - len%8, '\0');
+}
+
+static unsigned int nextRandom(unsigned int &state)
+{
+    state = state * 1103515245u + 12345u;
+    return state >> 8;
+}
+
+static void buildTables(const genOptions &opt, unsigned int fileNum,
+                        unsigned int &state, vector<genTable> &tables)
+{
+    genTable t;
+    unsigned long now = 1500000000ul + fileNum;
+
+    t.id = 0x04;
+    t.data.clear();
+    appendValue<unsigned int>(t.data, 0x1);
+    tables.push_back(t);
+
+    t.id = 0x05;
+    t.data.clear();
+    appendValue<unsigned int>(t.data, fileNum);
+    tables.push_back(t);
+
+    t.id = 0x06;
+    t.data.clear();
+    appendValue<unsigned long>(t.data, now);
+    tables.push_back(t);
+
+    // Database map: resource ids first, then the data tables.
+    unsigned int numRes = opt.mapEntries / 2;
+    unsigned int numData = opt.mapEntries;
+    t.id = 0x07;
+    t.data.clear();
+    appendValue<unsigned int>(t.data, numRes);
+    appendValue<unsigned int>(t.data, numData);
+
+    for(unsigned int i=0; i<numRes; ++i) {
+        appendValue<unsigned long>(t.data, 0x100 + i);
+    }
+
+    for(unsigned int i=0; i<numRes; ++i) {
+        appendValue<unsigned int>(t.data, nextRandom(state) % 0x40);
+    }
+
+    for(unsigned int i=numRes; i<numData; ++i) {
+        appendValue<unsigned long>(t.data, 0x100 + i);
+    }
+
+    for(unsigned int i=numRes; i<numData; ++i) {
+        appendValue<unsigned int>(t.data, nextRandom(state) % 0x40);
+    }
+
+    tables.push_back(t);
+
+    t.id = 0x19;
+    t.data.clear();
+    appendValue<unsigned long>(t.data, now - 86400);
+    tables.push_back(t);
+
+    t.id = 0x1c;
+    t.data.clear();
+    appendValue<unsigned short>(t.data, 4);
+    appendName(t.data, "bench-dm");
+    tables.push_back(t);
+
+    t.id = 0x1d;
+    t.data.clear();
+    oafp::appInfo ai = {4, 4, 43, 22};
+    append(t.data, &ai, sizeof(ai));
+    appendName(t.data, "benchGenerate");
+    appendName(t.data, "oaFileParser");
+    appendName(t.data, "linux_rhel50_gcc48x_64");
+    tables.push_back(t);
+
+    t.id = 0x1f;
+    t.data.clear();
+    appendValue<unsigned long>(t.data, 2);
+    appendValue<unsigned long>(t.data, 0x100 + numData);
+    appendValue<unsigned long>(t.data, 0x101 + numData);
+    appendValue<unsigned int>(t.data, 0x10);
+    appendValue<unsigned int>(t.data, 0x11);
+    tables.push_back(t);
+
+    for(unsigned int i=0; i<opt.tables; ++i) {
+        t.id = 0x100 + i;
+        t.data.assign(opt.fillerSize, '\0');
+
+        for(unsigned int b=0; b<opt.fillerSize; b+=4) {
+            t.data[b] = nextRandom(state);
+        }
+
+        tables.push_back(t);
+    }
+
+    t.id = 0x28;
+    t.data.clear();
+    appendValue<unsigned int>(t.data, 0x1);
+    tables.push_back(t);
+}
+
+static void buildStringTable(const genOptions &opt, unsigned int &state,
+                             string &data)
+{
+    static const char *prefixes[] = {"net", "inst", "cell", "pin", "term", "I", "M"};
+    string strings;
+    char name[64];
+
+    for(unsigned int i=0; i<opt.strings; ++i) {
+        int len = snprintf(name, sizeof(name), "%s%u_%u",
+                           prefixes[nextRandom(state) % 7], i, nextRandom(state) % 1000);
+        strings.append(name, len + 1);
+    }
+
+    oafp::tableIndex table;
+    table.size = strings.size() + strings.size() / 4;
+    table.used = strings.size();
+    table.deleted = 0;
+    table.first = 0;
+    data.clear();
+    append(data, &table, sizeof(table));
+    appendValue<unsigned int>(data, 0);
+    data += strings;
+}
+
+static int writeFile(const genOptions &opt, unsigned int fileNum,
+                     const string &path)
+{
+    unsigned int state = opt.seed + fileNum * 7919;
+    vector<genTable> tables;
+    buildTables(opt, fileNum, state, tables);
+    string strings;
+    buildStringTable(opt, state, strings);
+
+    oafp::oaFileWriter writer;
+    writer.setHeader(0x01020304, 0x1, 0x4);
+
+    for(size_t i=0; i<tables.size(); ++i) {
+        writer.addTable(tables[i].id, tables[i].data.data(), tables[i].data.size());
+    }
+
+    writer.addTable(0x0a, strings.data(), strings.size());
+    return writer.write(path.c_str());
+}
+
+
+// ****************************************************************************
+// main()
+// ****************************************************************************
+int main(int argc, char *argv[])
+{
+    genOptions opt = {100, 16, 10000, 1000, 4096, 1};
+    int arg = 1;
+
+    for(; arg+1<argc && strncmp(argv[arg], "--", 2)==0; arg+=2) {
+        unsigned int value = strtoul(argv[arg+1], NULL, 0);
+
+        if(strcmp(argv[arg], "--files")==0) {
+            opt.files = value;
+        } else if(strcmp(argv[arg], "--tables")==0) {
+            opt.tables = value;
+        } else if(strcmp(argv[arg], "--strings")==0) {
+            opt.strings = value;
+        } else if(strcmp(argv[arg], "--map")==0) {
+            opt.mapEntries = value;
+        } else if(strcmp(argv[arg], "--table-size")==0) {
+            opt.fillerSize = value;
+        } else if(strcmp(argv[arg], "--seed")==0) {
+            opt.seed = value;
+        } else {
+            break;
+        }
+    }
+
+    if(arg+1!=argc) {
+        fprintf(stderr, "Usage: ./benchGenerate [--files N] [--tables N] [--strings N]\n"
+                "                       [--map N] [--table-size BYTES] [--seed N] outDir\n");
+        return 1;
+    }
+
+    string dir = argv[arg];
+
+    for(unsigned int i=0; i<opt.files; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "/cell%05u.oa", i);
+
+        if(writeFile(opt, i, dir + name)!=0) {
+            fprintf(stderr, "Unable to write %s%s\n", dir.c_str(), name);
+            return 1;
+        }
+    }
+
+    return 0;
+}
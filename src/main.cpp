@@ -30,98 +30,125 @@
  */
 
 #include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <cstdio>
 #include <iostream>
 #include <iomanip>
 #include <cstring>
+#include <map>
+#include <sstream>
+#include <vector>
 
 #include "oaFileParser.h"
+#include "oaFileVerifier.h"
+#include "oaFileWriter.h"
+#include "oaLibraryScanner.h"
+#include "oaLibraryWatcher.h"
+#include "oaOutputBuffer.h"
+#include "oaParseCache.h"
+#include "oaParseStats.h"
+#include "oaStaticParser.h"
+#include "oaStringSearch.h"
+#include "oaStringTable.h"
+#include "oaTableHash.h"
 
 using namespace std;
 
 class MyTestParser : public oafp::oaFileParser
 {
+public:
+    MyTestParser(ostream &out = cout, ostream &err = cerr)
+        : out(out), err(err) {
+        setIndexStrings(true);
+    };
+
 protected:
     virtual void onParsedPreface(unsigned int testBit, unsigned short type,
                                  unsigned short schema, unsigned long offset, unsigned int size,
                                  unsigned int used) {
-        cout << "File Preface Information: " << endl;
-        cout << "\ttestBit: 0x" << setfill('0') << setw(8) << hex << testBit << endl;
-        cout << "\ttype:    0x" << setfill('0') << setw(8) << hex << type    << endl;
-        cout << "\tschema:  0x" << setfill('0') << setw(8) << hex << schema  << endl;
-        cout << "\toffset:  0x" << setfill('0') << setw(8) << hex << offset  << endl;
-        cout << "\tsize:    " << dec << size    << endl;
-        cout << "\tused:    " << dec << used    << endl;
+        out << "File Preface Information: " << endl;
+        out << "\ttestBit: 0x" << setfill('0') << setw(8) << hex << testBit << endl;
+        out << "\ttype:    0x" << setfill('0') << setw(8) << hex << type    << endl;
+        out << "\tschema:  0x" << setfill('0') << setw(8) << hex << schema  << endl;
+        out << "\toffset:  0x" << setfill('0') << setw(8) << hex << offset  << endl;
+        out << "\tsize:    " << dec << size    << endl;
+        out << "\tused:    " << dec << used    << endl;
     };
     virtual void onParsedTableInformation(unsigned long ids[],
                                           unsigned long offsets[],
                                           unsigned long sizes[],
                                           unsigned int num) {
-        cout << "Table Information: " << endl;
+        out << "Table Information: " << endl;
 
         for(int i=0; i<num; ++i) {
-            cout << "\ttable #" << setw(3) << i << " type: 0x" << setfill('0') << setw(
+            out << "\ttable #" << setw(3) << i << " type: 0x" << setfill('0') << setw(
                      4) << hex << ids[i] << " offset: 0x" << setfill('0') << setw(16) <<
                  (hex) << offsets[i] << " tableSize: " << (dec) << sizes[i] << endl;
         }
     };
     virtual void onParsedFlags(unsigned int flags) {
-        cout << "Database Flags: 0x" << setw(8) << hex << flags << endl;
+        out << "Database Flags: 0x" << setw(8) << hex << flags << endl;
     };
     virtual void onParsedTimeStamp(unsigned int timeStamp) {
-        cout << "Database Timestamp: " << timeStamp << endl;
+        out << "Database Timestamp: " << timeStamp << endl;
     };
     virtual void onParsedLastSavedTime(unsigned long lsTime) {
-        cout << "Database Last Saved Time: " << endl;
-        struct tm *timeInfo;
-        timeInfo = gmtime((time_t *)&lsTime);
-        cout << "\tTime Raw:   0x" << lsTime << endl;
-        cout << "\tGMT:        " << asctime(
-                 timeInfo);  // asctime puts the EOL for you.
-        timeInfo = localtime((time_t *)&lsTime);
-        cout << "\tLocal Time: " << asctime(timeInfo);
+        out << "Database Last Saved Time: " << endl;
+        struct tm timeInfo;
+        char timeText[32];
+        gmtime_r((time_t *)&lsTime, &timeInfo);
+        out << "\tTime Raw:   0x" << lsTime << endl;
+        out << "\tGMT:        " << asctime_r(&timeInfo,
+                 timeText);  // asctime puts the EOL for you.
+        localtime_r((time_t *)&lsTime, &timeInfo);
+        out << "\tLocal Time: " << asctime_r(&timeInfo, timeText);
     };
     virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
                                      unsigned int idCount, unsigned long tblIds[],
                                      unsigned int tblTypes[], unsigned int tblCount) {
-        cout << "Database Map" << endl;
-        cout << "\tNumber of ids: " << idCount << endl;
+        out << "Database Map" << endl;
+        out << "\tNumber of ids: " << idCount << endl;
 
         for(int i=0; i<idCount; ++i) {
-            cout << "\t\tids: 0x" << setfill('0') << setw(8) << hex << ids[i] <<
+            out << "\t\tids: 0x" << setfill('0') << setw(8) << hex << ids[i] <<
                  "\ttypes: 0x" << setfill('0') << setw(8) << hex << types[i] << endl;
         }
 
-        cout << "\tNumber of tables: " << tblCount << endl;
+        out << "\tNumber of tables: " << tblCount << endl;
 
         for(int i=0; i<tblCount; ++i) {
-            cout << "\t\ttable ids: 0x" << setfill('0') << setw(8) << hex << tblIds[i] <<
+            out << "\t\ttable ids: 0x" << setfill('0') << setw(8) << hex << tblIds[i] <<
                  "\ttable types: 0x" << setfill('0') << setw(8) << hex << tblTypes[i] << endl;
         }
     };
     virtual void onParsedStringTable(oafp::tableIndex table, const char *buffer) {
-        cout << "Database String Table: " << endl;
-        cout << "\tSize:    " << table.size    << endl;
-        cout << "\tUsed:    " << table.used    << endl;
-        cout << "\tDeleted: " << table.deleted << endl;
-        cout << "\tFirst:   " << table.first   << endl;
-        unsigned int b = 0;
-        unsigned int l = 0;
-        cout << "\tStrings: ";
+        oafp::oaStringTable strings;
+        strings.build(table, buffer);
+        onParsedStringTableIndex(strings);
+    };
+    virtual void onParsedStringTableIndex(const oafp::oaStringTable &strings) {
+        const oafp::tableIndex &table = strings.table();
+        out << "Database String Table: " << endl;
+        out << "\tSize:    " << table.size    << endl;
+        out << "\tUsed:    " << table.used    << endl;
+        out << "\tDeleted: " << table.deleted << endl;
+        out << "\tFirst:   " << table.first   << endl;
+        out << "\tStrings: ";
 
-        while(b<table.used) {
-            const char *ptr = &buffer[b];
-            l = strlen(ptr);
-            cout << ptr << "|";
-            b += l + 1;
+        for(unsigned int i=0; i<strings.count(); ++i) {
+            out.write(strings.string(i), strings.length(i));
+            out << "|";
         }
 
-        cout << endl;
+        out << endl;
     };
     virtual void onParsedCreateTime(unsigned long createTime) {
-        cout << "Database Create Time: " << endl;
-        struct tm *timeInfo;
+        out << "Database Create Time: " << endl;
+        struct tm timeInfo;
+        char timeText[32];
         unsigned int downTime[2];
 
         // Something going on with time time in versions of >=22.43
@@ -132,54 +159,938 @@ protected:
             tt = downTime[1];
         }
 
-        timeInfo = gmtime((time_t *)&tt);
-        //cout << "\tCreate Time Raw:   0x" << createTime << endl;
-        cout << "\tCreate Time Raw:   0x" << tt << endl;
-        cout << "\tCreate GMT:        "   << asctime(
-                 timeInfo);  // asctime puts the EOL for you.
-        timeInfo = localtime((time_t *)&tt);
-        cout << "\tCreate Local Time: "   << asctime(timeInfo);
+        gmtime_r((time_t *)&tt, &timeInfo);
+        //out << "\tCreate Time Raw:   0x" << createTime << endl;
+        out << "\tCreate Time Raw:   0x" << tt << endl;
+        out << "\tCreate GMT:        "   << asctime_r(&timeInfo,
+                 timeText);  // asctime puts the EOL for you.
+        localtime_r((time_t *)&tt, &timeInfo);
+        out << "\tCreate Local Time: "   << asctime_r(&timeInfo, timeText);
     };
     virtual void onParsedDMandBuildName(unsigned short dataModelRev,
                                         const char *buildName) {
-        cout << "Database Data Model Revision: " << endl;
-        cout << "\tData Model Revision: " << dataModelRev << endl;
-        cout << "\tBuild Name:          " << buildName << endl;
+        out << "Database Data Model Revision: " << endl;
+        out << "\tData Model Revision: " << dataModelRev << endl;
+        out << "\tBuild Name:          " << buildName << endl;
     };
     virtual void onParsedBuildInformation(unsigned short appDataModelRev,
                                           unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
                                           unsigned short kitReleaseNum, const char *appBuildName,
                                           const char *kitBuildName, const char *platforName) {
-        cout << "Database Software Build Information: " << endl;
-        cout << "\tAppDataModelRev: " << appDataModelRev << endl;
-        cout << "\tKitDataModelRev: " << kitDataModelRev << endl;
-        cout << "\tAppAPIMinorRev:  " << appAPIMinorRev  << endl;
-        cout << "\tKitReleaseNum:   " << kitReleaseNum   << endl;
-        cout << "\tAppBuildName:    " << appBuildName    << endl;
-        cout << "\tKitBuildName:    " << kitBuildName    << endl;
-        cout << "\tPlatforName:     " << platforName     << endl;
+        out << "Database Software Build Information: " << endl;
+        out << "\tAppDataModelRev: " << appDataModelRev << endl;
+        out << "\tKitDataModelRev: " << kitDataModelRev << endl;
+        out << "\tAppAPIMinorRev:  " << appAPIMinorRev  << endl;
+        out << "\tKitReleaseNum:   " << kitReleaseNum   << endl;
+        out << "\tAppBuildName:    " << appBuildName    << endl;
+        out << "\tKitBuildName:    " << kitBuildName    << endl;
+        out << "\tPlatforName:     " << platforName     << endl;
     };
     virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
                                       unsigned long num) {
-        cout << "Database Data Table Map Delta" << endl;
-        cout << "\tNumber of New Data Tables: " << num << endl;
+        out << "Database Data Table Map Delta" << endl;
+        out << "\tNumber of New Data Tables: " << num << endl;
 
         for(int i=0; i<num; ++i) {
-            cout << "\t\tIDs: 0x" << setfill('0') << setw(8) << hex << ids[i] <<
+            out << "\t\tIDs: 0x" << setfill('0') << setw(8) << hex << ids[i] <<
                  "\tTypes: 0x" << setfill('0') << setw(8) << hex << setfill('0') << setw(
                      8) << hex << types[i] << endl;
         };
     };
     virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
-        cout << "Database EOD Marker: " << endl;
-        cout << "\tMarker: " << bitCheck << endl;
+        out << "Database EOD Marker: " << endl;
+        out << "\tMarker: " << bitCheck << endl;
+    };
+    virtual void onParsedError(const char *error) {
+        err << error << endl;
+    };
+    virtual void onParsedStringTableBegin(const oafp::tableIndex &table) {
+        out << "Database String Table: " << endl;
+        out << "\tSize:    " << table.size    << endl;
+        out << "\tUsed:    " << table.used    << endl;
+        out << "\tDeleted: " << table.deleted << endl;
+        out << "\tFirst:   " << table.first   << endl;
+        out << "\tStrings: ";
+    };
+    virtual void onParsedStringTableChunk(const char *strings, unsigned long size,
+                                          unsigned long offset) {
+        for(const char *s=strings; s<strings + size; s+=strlen(s) + 1) {
+            out << s << "|";
+        }
+    };
+    virtual void onParsedStringTableEnd() {
+        out << endl;
+    };
+    virtual void onParsedDatabaseMapBegin(unsigned int idCount,
+                                          unsigned int tblCount) {
+        out << "Database Map" << endl;
+        out << "\tNumber of ids: " << idCount << endl;
+        mapTables = tblCount;
+        mapTablesShown = false;
+    };
+    virtual void onParsedDatabaseMapChunk(unsigned long ids[], unsigned int types[],
+                                          unsigned int num, bool dataTables) {
+        if(dataTables && !mapTablesShown) {
+            out << "\tNumber of tables: " << mapTables << endl;
+            mapTablesShown = true;
+        }
+
+        for(unsigned int i=0; i<num; ++i) {
+            out << (dataTables ? "\t\ttable ids: 0x" : "\t\tids: 0x") << setfill('0') <<
+                setw(8) << hex << ids[i] << (dataTables ? "\ttable types: 0x" : "\ttypes: 0x")
+                << setfill('0') << setw(8) << hex << types[i] << endl;
+        }
+    };
+    virtual void onParsedDatabaseMapEnd() {
+        if(!mapTablesShown) {
+            out << "\tNumber of tables: " << mapTables << endl;
+        }
+    };
+    virtual void onParsedDataTables(const oafp::dataTableBatch &batch) {
+        out << "Data Tables: " << dec << batch.num << " tables, " << batch.bytes <<
+            " bytes" << endl;
+
+        for(unsigned int i=0; i<batch.num; ++i) {
+            out << "\t\ttable: 0x" << setfill('0') << setw(8) << hex << batch.ids[i] <<
+                "\ttype: 0x" << setfill('0') << setw(8) << hex << batch.types[i] <<
+                "\tsize: " << dec << batch.sizes[i] << endl;
+        }
+    };
+
+private:
+    ostream &out;
+    ostream &err;
+    unsigned int mapTables;
+    bool mapTablesShown;
+};
+
+
+// ****************************************************************************
+// MyJsonParser
+//
+// Writes one JSON object per file on a single line, so multi-file runs
+// produce NDJSON.  Ids, types and flags are hex strings, everything else is
+// a plain number.
+// ****************************************************************************
+class MyJsonParser : public oafp::oaFileParser
+{
+public:
+    MyJsonParser(oafp::oaOutputBuffer &out)
+        : out(out) {
+        setIndexStrings(true);
+    };
+
+    void beginRecord(const char *filePath) {
+        out.append("{\"file\":");
+        out.appendString(filePath);
+    };
+    void endRecord(int status) {
+        out.append(",\"status\":");
+        out.appendUInt(status);
+        out.append("}\n", 2);
+    };
+
+protected:
+    virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                 unsigned short schema, unsigned long offset, unsigned int size,
+                                 unsigned int used) {
+        out.append(",\"preface\":{\"testBit\":");
+        appendHex(testBit, 8);
+        out.append(",\"type\":");
+        appendHex(type, 4);
+        out.append(",\"schema\":");
+        appendHex(schema, 4);
+        out.append(",\"offset\":");
+        out.appendUInt(offset);
+        out.append(",\"size\":");
+        out.appendUInt(size);
+        out.append(",\"used\":");
+        out.appendUInt(used);
+        out.append('}');
+    };
+    virtual void onParsedTableInformation(unsigned long ids[],
+                                          unsigned long offsets[],
+                                          unsigned long sizes[],
+                                          unsigned int num) {
+        out.append(",\"tables\":[");
+
+        for(unsigned int i=0; i<num; ++i) {
+            out.append(i==0 ? "{\"id\":" : ",{\"id\":");
+            appendHex(ids[i], 4);
+            out.append(",\"offset\":");
+            out.appendUInt(offsets[i]);
+            out.append(",\"size\":");
+            out.appendUInt(sizes[i]);
+            out.append('}');
+        }
+
+        out.append(']');
+    };
+    virtual void onParsedFlags(unsigned int flags) {
+        out.append(",\"flags\":");
+        appendHex(flags, 8);
+    };
+    virtual void onParsedTimeStamp(unsigned int timeStamp) {
+        out.append(",\"timeStamp\":");
+        out.appendUInt(timeStamp);
+    };
+    virtual void onParsedLastSavedTime(unsigned long lsTime) {
+        out.append(",\"lastSavedTime\":");
+        out.appendUInt(lsTime);
+    };
+    virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                     unsigned int idCount, unsigned long tblIds[],
+                                     unsigned int tblTypes[], unsigned int tblCount) {
+        out.append(",\"databaseMap\":{\"ids\":");
+        appendMap(ids, types, idCount);
+        out.append(",\"tables\":");
+        appendMap(tblIds, tblTypes, tblCount);
+        out.append('}');
+    };
+    virtual void onParsedStringTable(oafp::tableIndex table, const char *buffer) {
+        oafp::oaStringTable strings;
+        strings.build(table, buffer);
+        onParsedStringTableIndex(strings);
+    };
+    virtual void onParsedStringTableIndex(const oafp::oaStringTable &strings) {
+        const oafp::tableIndex &table = strings.table();
+        out.append(",\"stringTable\":{\"size\":");
+        out.appendUInt(table.size);
+        out.append(",\"used\":");
+        out.appendUInt(table.used);
+        out.append(",\"deleted\":");
+        out.appendUInt(table.deleted);
+        out.append(",\"first\":");
+        out.appendUInt(table.first);
+        out.append(",\"strings\":[");
+
+        for(unsigned int i=0; i<strings.count(); ++i) {
+            if(i>0) {
+                out.append(',');
+            }
+
+            out.appendString(strings.string(i), strings.length(i));
+        }
+
+        out.append("]}");
+    };
+    virtual void onParsedCreateTime(unsigned long createTime) {
+        unsigned int downTime[2];
+
+        // Same >=22.43 quirk as in MyTestParser.
+        memcpy(&downTime, &createTime, sizeof(downTime));
+        out.append(",\"createTime\":");
+        out.appendUInt(downTime[0]!=0 ? downTime[0] : downTime[1]);
+    };
+    virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                        const char *buildName) {
+        out.append(",\"dataModelRev\":");
+        out.appendUInt(dataModelRev);
+        out.append(",\"buildName\":");
+        out.appendString(buildName);
+    };
+    virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                          unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
+                                          unsigned short kitReleaseNum, const char *appBuildName,
+                                          const char *kitBuildName, const char *platforName) {
+        out.append(",\"buildInformation\":{\"appDataModelRev\":");
+        out.appendUInt(appDataModelRev);
+        out.append(",\"kitDataModelRev\":");
+        out.appendUInt(kitDataModelRev);
+        out.append(",\"appAPIMinorRev\":");
+        out.appendUInt(appAPIMinorRev);
+        out.append(",\"kitReleaseNum\":");
+        out.appendUInt(kitReleaseNum);
+        out.append(",\"appBuildName\":");
+        out.appendString(appBuildName);
+        out.append(",\"kitBuildName\":");
+        out.appendString(kitBuildName);
+        out.append(",\"platforName\":");
+        out.appendString(platforName);
+        out.append('}');
+    };
+    virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                      unsigned long num) {
+        out.append(",\"databaseMapDelta\":");
+        appendMap(ids, types, num);
+    };
+    virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
+        out.append(",\"marker\":");
+        out.appendUInt(bitCheck);
+    };
+    virtual void onParsedError(const char *error) {
+        out.append(",\"error\":");
+        out.appendString(error);
+    };
+
+private:
+    void appendHex(unsigned long value, unsigned int width) {
+        out.append("\"0x", 3);
+        out.appendHex(value, width);
+        out.append('"');
+    };
+    void appendMap(unsigned long ids[], unsigned int types[], unsigned long num) {
+        out.append('[');
+
+        for(unsigned long i=0; i<num; ++i) {
+            out.append(i==0 ? "{\"id\":" : ",{\"id\":");
+            appendHex(ids[i], 8);
+            out.append(",\"type\":");
+            appendHex(types[i], 8);
+            out.append('}');
+        }
+
+        out.append(']');
+    };
+
+    oafp::oaOutputBuffer &out;
+};
+
+
+// ****************************************************************************
+// MyRewriteParser
+//
+// Writes a copy of a file through oaFileWriter, tables in the original
+// index order.  The decoded tables are encoded again from their callbacks,
+// so a copy that parses the same shows the reader and the writer agree.
+// ****************************************************************************
+class MyRewriteParser : public oafp::oaFileParser
+{
+public:
+    MyRewriteParser() {
+        setDataTables(true);
+    };
+
+    int rewrite(const char *filePath, const char *outPath) {
+        if(parse(filePath)!=0) {
+            return 1;
+        }
+
+        oafp::oaFileWriter writer;
+        writer.setHeader(testBit, type, schema);
+
+        for(size_t i=0; i<order.size(); ++i) {
+            switch(order[i]) {
+                case 0x01:
+                    break;
+                case 0x04: writer.addFlags(flags);
+                    break;
+                case 0x05: writer.addTimeStamp(timeStamp);
+                    break;
+                case 0x06: writer.addLastSavedTime(lastSavedTime);
+                    break;
+                case 0x07: writer.addDatabaseMap(mapIds.data(), mapTypes.data(), idCount,
+                                                     mapIds.data() + idCount,
+                                                     mapTypes.data() + idCount,
+                                                     mapIds.size() - idCount);
+                    break;
+                case 0x0a: writer.addStringTable(stringIndex, strings.data());
+                    break;
+                case 0x19: writer.addCreateTime(createTime);
+                    break;
+                case 0x1c: writer.addDMandBuildName(dataModelRev, buildName.c_str());
+                    break;
+                case 0x1d: writer.addBuildInformation(revs[0], revs[1], revs[2], revs[3],
+                                                          appBuildName.c_str(),
+                                                          kitBuildName.c_str(),
+                                                          platformName.c_str());
+                    break;
+                case 0x1f: writer.addDatabaseMapD(deltaIds.data(), deltaTypes.data(),
+                                                      deltaIds.size());
+                    break;
+                case 0x28: writer.addDatabaseMarker(bitCheck);
+                    break;
+                default: {
+                    const string &data = tables[order[i]];
+                    writer.addTable(order[i], data.data(), data.size());
+                    break;
+                }
+            }
+        }
+
+        return writer.write(outPath);
+    };
+
+protected:
+    virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                 unsigned short schema, unsigned long offset, unsigned int size,
+                                 unsigned int used) {
+        this->testBit = testBit;
+        this->type = type;
+        this->schema = schema;
+    };
+    virtual void onParsedTableInformation(unsigned long ids[],
+                                          unsigned long offsets[],
+                                          unsigned long sizes[], unsigned int num) {
+        order.assign(ids, ids + num);
+
+        for(unsigned int i=0; i<num; ++i) {
+            if(ids[i]==0x0a) {
+                stringsSize = sizes[i];
+            }
+        }
+    };
+    virtual void onParsedFlags(unsigned int flags) {
+        this->flags = flags;
+    };
+    virtual void onParsedTimeStamp(unsigned int timeStamp) {
+        this->timeStamp = timeStamp;
+    };
+    virtual void onParsedLastSavedTime(unsigned long lastSavedTime) {
+        this->lastSavedTime = lastSavedTime;
+    };
+    virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                     unsigned int idCount, unsigned long tblIds[],
+                                     unsigned int tblTypes[], unsigned int tblCount) {
+        this->idCount = idCount;
+        mapIds.assign(ids, ids + idCount);
+        mapIds.insert(mapIds.end(), tblIds, tblIds + tblCount);
+        mapTypes.assign(types, types + idCount);
+        mapTypes.insert(mapTypes.end(), tblTypes, tblTypes + tblCount);
+    };
+    virtual void onParsedStringTable(oafp::tableIndex table, const char *buffer) {
+        // Only the used strings are kept, as far as they fit the table.
+        unsigned long room = stringsSize - sizeof(table) - sizeof(unsigned int);
+        stringIndex = table;
+        stringIndex.used = min<unsigned long>(table.used, room);
+        strings.assign(buffer, stringIndex.used);
+    };
+    virtual void onParsedCreateTime(unsigned long createTime) {
+        this->createTime = createTime;
+    };
+    virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                        const char *buildName) {
+        this->dataModelRev = dataModelRev;
+        this->buildName = buildName;
+    };
+    virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                          unsigned short kitDataModelRev,
+                                          unsigned short appAPIMinorRev,
+                                          unsigned short kitReleaseNum,
+                                          const char *appBuildName,
+                                          const char *kitBuildName,
+                                          const char *platforName) {
+        revs[0] = appDataModelRev;
+        revs[1] = kitDataModelRev;
+        revs[2] = appAPIMinorRev;
+        revs[3] = kitReleaseNum;
+        this->appBuildName = appBuildName;
+        this->kitBuildName = kitBuildName;
+        platformName = platforName;
+    };
+    virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                      unsigned long num) {
+        deltaIds.assign(ids, ids + num);
+        deltaTypes.assign(types, types + num);
+    };
+    virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
+        this->bitCheck = bitCheck;
     };
     virtual void onParsedError(const char *error) {
         cerr << error << endl;
     };
+    virtual void onParsedDataTables(const oafp::dataTableBatch &batch) {
+        for(unsigned int i=0; i<batch.num; ++i) {
+            tables[batch.ids[i]].assign(batch.data[i], batch.sizes[i]);
+        }
+    };
+
+private:
+    unsigned int testBit = 0;
+    unsigned short type = 0;
+    unsigned short schema = 0;
+    vector<unsigned long> order;
+    unsigned int flags = 0;
+    unsigned int timeStamp = 0;
+    unsigned long lastSavedTime = 0;
+    unsigned int idCount = 0;
+    vector<unsigned long> mapIds;
+    vector<unsigned int> mapTypes;
+    unsigned long stringsSize = 0;
+    oafp::tableIndex stringIndex = {0, 0, 0, 0};
+    string strings;
+    unsigned long createTime = 0;
+    unsigned short dataModelRev = 0;
+    string buildName;
+    unsigned short revs[4] = {0, 0, 0, 0};
+    string appBuildName;
+    string kitBuildName;
+    string platformName;
+    vector<unsigned long> deltaIds;
+    vector<unsigned int> deltaTypes;
+    unsigned int bitCheck = 0;
+    map<unsigned long, string> tables;
 };
 
 
+// ****************************************************************************
+// MyAuditParser
+//
+// Answers "which build and data model wrote this file?" in one line.  Only
+// the 0x1c and 0x1d tables are ever read.
+// ****************************************************************************
+class MyAuditParser : public oafp::oaStaticParser<MyAuditParser>
+{
+public:
+    MyAuditParser(ostream &out = cout, ostream &err = cerr)
+        : out(out), err(err) {
+    };
+
+    int audit(const char *filePath) {
+        out << filePath;
+        int status = parse(filePath);
+        out << endl;
+        return status;
+    };
+
+    void onParsedDMandBuildName(unsigned short dataModelRev,
+                                const char *buildName) {
+        out << "\tdataModelRev: " << dec << dataModelRev << "\tbuildName: " <<
+            buildName;
+    };
+    void onParsedBuildInformation(unsigned short appDataModelRev,
+                                  unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
+                                  unsigned short kitReleaseNum, const char *appBuildName,
+                                  const char *kitBuildName, const char *platforName) {
+        out << "\tappBuildName: " << appBuildName << "\tkitBuildName: " <<
+            kitBuildName << "\tplatforName: " << platforName;
+    };
+    void onParsedError(const char *error) {
+        err << error << endl;
+    };
+
+private:
+    ostream &out;
+    ostream &err;
+};
+
+
+// ****************************************************************************
+// MyLibraryScanner
+//
+// Runs a MyTestParser over every file of a library and prints the reports in
+// path order.
+// ****************************************************************************
+class MyLibraryScanner : public oafp::oaLibraryScanner
+{
+public:
+    MyLibraryScanner(unsigned int numThreads, bool mapped, bool audit,
+                     oafp::oaParseCache *cache, bool collectStats,
+                     oafp::oaOutputBuffer *json)
+        : oafp::oaLibraryScanner(numThreads), mapped(mapped), audit(audit),
+          cache(cache), workerStats(collectStats ? threads() : 0), json(json) {
+    };
+
+    // Folds the counters of all workers into stats.
+    void mergeStats(oafp::oaParseStats &stats) const {
+        for(size_t i=0; i<workerStats.size(); ++i) {
+            stats.merge(workerStats[i]);
+        }
+    };
+
+protected:
+    virtual int onScanFile(unsigned int worker, const string &path,
+                           string &result, string &error) {
+        ostringstream out;
+        ostringstream err;
+        int status;
+
+        if(json!=NULL) {
+            // Each record is built in a worker-local buffer and copied to
+            // the shared one in path order by onScanResult().
+            oafp::oaOutputBuffer record(-1, 16 * 1024);
+            MyJsonParser parser(record);
+
+            if(worker<workerStats.size()) {
+                parser.setStats(&workerStats[worker]);
+            }
+
+            parser.beginRecord(path.c_str());
+
+            if(cache!=NULL) {
+                status = parser.parseCached(path.c_str(), *cache);
+            } else if(mapped) {
+                status = parser.parseMapped(path.c_str());
+            } else {
+                status = parser.parse(path.c_str());
+            }
+
+            parser.endRecord(status);
+            result.assign(record.data(), record.size());
+            return status;
+        }
+
+        if(audit) {
+            MyAuditParser parser(out, err);
+            status = parser.audit(path.c_str());
+        } else {
+            MyTestParser parser(out, err);
+
+            // Each worker owns one stats object, so no locking is needed.
+            if(worker<workerStats.size()) {
+                parser.setStats(&workerStats[worker]);
+            }
+
+            if(cache!=NULL) {
+                status = parser.parseCached(path.c_str(), *cache);
+            } else if(mapped) {
+                status = parser.parseMapped(path.c_str());
+            } else {
+                status = parser.parse(path.c_str());
+            }
+        }
+
+        result = out.str();
+        error = err.str();
+        return status;
+    };
+    virtual void onScanResult(const string &path, int status,
+                              const string &result, const string &error) {
+        if(json!=NULL) {
+            json->append(result.data(), result.size());
+            return;
+        }
+
+        if(!audit) {
+            cout << "File: " << path << endl;
+        }
+
+        cout << result;
+
+        if(status!=0) {
+            cerr << path << ": " << error;
+        }
+    };
+
+private:
+    bool mapped;
+    bool audit;
+    oafp::oaParseCache *cache;
+    vector<oafp::oaParseStats> workerStats;
+    oafp::oaOutputBuffer *json;
+};
+
+
+// ****************************************************************************
+// MyGrepScanner
+//
+// Prints "path:string" for every string of a library's string tables that
+// contains the pattern.  Only the string table of each file is mapped.
+// ****************************************************************************
+class MyGrepScanner : public oafp::oaLibraryScanner
+{
+public:
+    MyGrepScanner(unsigned int numThreads, const string &pattern)
+        : oafp::oaLibraryScanner(numThreads), matchedFiles(0), search(pattern) {
+    };
+
+    unsigned long matchedFiles;
+
+protected:
+    virtual int onScanFile(unsigned int worker, const string &path,
+                           string &result, string &error) {
+        vector<string> found;
+
+        if(search.searchFile(path.c_str(), found)!=0) {
+            error = "Unable to read the string table.\n";
+            return 1;
+        }
+
+        for(size_t i=0; i<found.size(); ++i) {
+            result.append(path);
+            result.append(1, ':');
+            result.append(found[i]);
+            result.append(1, '\n');
+        }
+
+        return 0;
+    };
+    virtual void onScanResult(const string &path, int status,
+                              const string &result, const string &error) {
+        if(status!=0) {
+            cerr << path << ": " << error;
+            return;
+        }
+
+        if(!result.empty()) {
+            fwrite(result.data(), 1, result.size(), stdout);
+            matchedFiles += 1;
+        }
+    };
+
+private:
+    oafp::oaStringSearch search;
+};
+
+
+// ****************************************************************************
+// MyBatchParser
+//
+// Prints the reports of every file of a library like --scan does, but
+// parses them all on one thread through parseFiles(), which keeps the reads
+// of many files in flight at once.
+// ****************************************************************************
+class MyBatchParser : public MyTestParser
+{
+public:
+    MyBatchParser()
+        : MyTestParser(cout, errors) {
+    };
+
+protected:
+    virtual void onParsedFileBegin(const char *filePath) {
+        cout << "File: " << filePath << endl;
+    };
+    virtual void onParsedFileEnd(const char *filePath, int status) {
+        if(status!=0) {
+            cerr << filePath << ": " << errors.str();
+        }
+
+        errors.str("");
+    };
+
+private:
+    ostringstream errors;
+};
+
+
+// ****************************************************************************
+// MyVerifyScanner
+//
+// Prints "path: OK" for every file of a library whose structure is sound,
+// and the first problem found otherwise.  Nothing is decoded.
+// ****************************************************************************
+class MyVerifyScanner : public oafp::oaLibraryScanner
+{
+public:
+    MyVerifyScanner(unsigned int numThreads)
+        : oafp::oaLibraryScanner(numThreads), failures(0) {
+    };
+
+    unsigned long failures;
+
+protected:
+    virtual int onScanFile(unsigned int worker, const string &path,
+                           string &result, string &error) {
+        oafp::verifyReport report;
+
+        if(oafp::verifyFile(path.c_str(), report)==oafp::verifyOk) {
+            return 0;
+        }
+
+        ostringstream out;
+        out << report.message;
+
+        if(report.status==oafp::verifyTableOverlap) {
+            out << " (tables 0x" << hex << setw(2) << setfill('0') << report.table <<
+                " and 0x" << setw(2) << report.other << ")";
+        } else if(report.status>=oafp::verifyTableOutOfRange) {
+            out << " (table 0x" << hex << setw(2) << setfill('0') << report.table << ")";
+        }
+
+        error = out.str();
+        return 1;
+    };
+    virtual void onScanResult(const string &path, int status,
+                              const string &result, const string &error) {
+        if(status!=0) {
+            cout << path << ": FAIL " << error << "\n";
+            failures += 1;
+        } else {
+            cout << path << ": OK\n";
+        }
+    };
+};
+
+
+// ****************************************************************************
+// MyLibraryWatcher
+//
+// Prints the report of every file once and then the reports of the files
+// that change, until interrupted.
+// ****************************************************************************
+class MyLibraryWatcher : public oafp::oaLibraryWatcher
+{
+public:
+    MyLibraryWatcher(unsigned int numThreads)
+        : oafp::oaLibraryWatcher(numThreads) {
+    };
+
+protected:
+    virtual int onParseFile(const string &path, string &result) {
+        ostringstream out;
+        MyTestParser parser(out, out);
+        int status = parser.parse(path.c_str());
+        result = out.str();
+        return status;
+    };
+    virtual void onFileChanged(changeType change, const string &path,
+                               const catalogEntry &entry) {
+        static const char *changes[] = {"Added", "Modified", "Removed"};
+        cout << changes[change] << ": " << path << endl;
+
+        if(change!=fileRemoved) {
+            cout << entry.result;
+        }
+
+        cout << flush;
+    };
+};
+
+static MyLibraryWatcher *activeWatcher = NULL;
+
+static void stopWatching(int signal)
+{
+    if(activeWatcher!=NULL) {
+        activeWatcher->stop();
+    }
+}
+
+
+// ****************************************************************************
+// diffFiles()
+//
+// Compares two revisions of a file table by table.  Only tables whose raw
+// bytes hash differently are decoded, and their reports are printed with
+// "<" and ">" in front like diff does.  Returns 0 if the files have the
+// same tables, 1 if they differ and 2 if either cannot be read.
+// ****************************************************************************
+static void printReport(const string &report, const char *prefix)
+{
+    istringstream in(report);
+    string line;
+
+    while(getline(in, line)) {
+        cout << prefix << line << "\n";
+    }
+}
+
+static int diffFiles(const char *pathA, const char *pathB)
+{
+    ostringstream reportA;
+    ostringstream reportB;
+    MyTestParser parserA(reportA);
+    MyTestParser parserB(reportB);
+    oafp::tableDirectory dirA;
+    oafp::tableDirectory dirB;
+    vector<unsigned long> hashesA;
+    vector<unsigned long> hashesB;
+
+    if(parserA.readDirectory(pathA, dirA)!=0 ||
+       parserB.readDirectory(pathB, dirB)!=0 ||
+       oafp::hashTables(dirA, hashesA)!=0 || oafp::hashTables(dirB, hashesB)!=0) {
+        cerr << "Unable to read " << pathA << " or " << pathB << endl;
+        return 2;
+    }
+
+    cout << "--- " << pathA << "\n";
+    cout << "+++ " << pathB << "\n";
+    int differ = 0;
+
+    for(unsigned int i=0; i<dirA.header.used; ++i) {
+        unsigned long id = dirA.ids[i];
+        int j = dirB.find(id);
+
+        // 0x01 spans the index tables, which are compared one by one.
+        if(id==0x01 || dirA.find(id)!=(int)i) {
+            continue;
+        }
+
+        if(j<0) {
+            cout << "Only in " << pathA << ": table 0x" << setfill('0') << setw(4) <<
+                 hex << id << dec << "\n";
+            differ = 1;
+            continue;
+        }
+
+        if(hashesA[i]==hashesB[j] && dirA.sizes[i]==dirB.sizes[j]) {
+            continue;
+        }
+
+        cout << "Changed: table 0x" << setfill('0') << setw(4) << hex << id << dec <<
+             " tableSize: " << dirA.sizes[i] << " -> " << dirB.sizes[j] << "\n";
+        differ = 1;
+        reportA.str("");
+        reportB.str("");
+
+        // Tables without a decoder are only listed.
+        if(parserA.parseTable(dirA, id)==0 && parserB.parseTable(dirB, id)==0) {
+            printReport(reportA.str(), "< ");
+            printReport(reportB.str(), "> ");
+        }
+    }
+
+    for(unsigned int j=0; j<dirB.header.used; ++j) {
+        if(dirB.ids[j]!=0x01 && dirA.find(dirB.ids[j])<0 &&
+           dirB.find(dirB.ids[j])==(int)j) {
+            cout << "Only in " << pathB << ": table 0x" << setfill('0') << setw(4) <<
+                 hex << dirB.ids[j] << dec << "\n";
+            differ = 1;
+        }
+    }
+
+    cout << flush;
+    return differ;
+}
+
+
+// ****************************************************************************
+// runParser()
+//
+// Parses a single file in the mode selected on the command line.
+// ****************************************************************************
+static int runParser(oafp::oaFileParser &parser, const char *path,
+                     const vector<unsigned long> &tables, const char *cachePath,
+                     oafp::oaParseCache &cache, bool mapped, bool stream,
+                     bool parallel, unsigned int threads)
+{
+    if(!tables.empty()) {
+        oafp::tableDirectory dir;
+
+        if(parser.readDirectory(path, dir)!=0) {
+            return 1;
+        }
+
+        for(size_t i=0; i<tables.size(); ++i) {
+            if(parser.parseTable(dir, tables[i])!=0) {
+                cerr << "Table 0x" << hex << tables[i] << " is not available." << endl;
+            }
+        }
+
+        return 0;
+    }
+
+    if(cachePath!=NULL) {
+        int status = parser.parseCached(path, cache);
+        cache.save(cachePath);
+        return status;
+    }
+
+    if(mapped) {
+        return parser.parseMapped(path);
+    }
+
+    if(parallel) {
+        return parser.parseParallel(path, threads);
+    }
+
+    if(stream) {
+        int fd = strcmp(path, "-")==0 ? 0 : open(path, O_RDONLY);
+
+        if(fd<0) {
+            cerr << "Unable to open " << path << endl;
+            return 1;
+        }
+
+        int status = parser.parseStream(fd);
+        close(fd);
+        return status;
+    }
+
+    return parser.parse(path);
+}
+
+
 // ****************************************************************************
 // main()
 //
@@ -187,13 +1098,229 @@ protected:
 // ****************************************************************************
 int main(int argc, char *argv[])
 {
-    if(argc<2) {
+    bool mapped = false;
+    bool stream = false;
+    bool scan = false;
+    bool watch = false;
+    bool audit = false;
+    bool json = false;
+    bool data = false;
+    bool diff = false;
+    bool parallel = false;
+    bool verify = false;
+    bool async = false;
+    const char *rewritePath = NULL;
+    unsigned int depth = 64;
+    unsigned int threads = 0;
+    vector<unsigned long> tables;
+    const char *cachePath = NULL;
+    const char *statsPath = NULL;
+    unsigned long budget = 0;
+    const char *grepPattern = NULL;
+    int arg = 1;
+
+    for(; arg<argc && strncmp(argv[arg], "--", 2)==0; ++arg) {
+        if(strcmp(argv[arg], "--mmap")==0) {
+            mapped = true;
+        } else if(strcmp(argv[arg], "--stream")==0) {
+            stream = true;
+        } else if(strcmp(argv[arg], "--audit")==0) {
+            audit = true;
+        } else if(strcmp(argv[arg], "--parallel")==0) {
+            parallel = true;
+        } else if(strcmp(argv[arg], "--rewrite")==0 && arg+1<argc) {
+            rewritePath = argv[++arg];
+        } else if(strcmp(argv[arg], "--async")==0) {
+            async = true;
+        } else if(strcmp(argv[arg], "--depth")==0 && arg+1<argc) {
+            depth = atoi(argv[++arg]);
+        } else if(strcmp(argv[arg], "--verify")==0) {
+            verify = true;
+        } else if(strcmp(argv[arg], "--diff")==0) {
+            diff = true;
+        } else if(strcmp(argv[arg], "--data")==0) {
+            data = true;
+        } else if(strcmp(argv[arg], "--json")==0) {
+            json = true;
+        } else if(strcmp(argv[arg], "--scan")==0) {
+            scan = true;
+        } else if(strcmp(argv[arg], "--watch")==0) {
+            watch = true;
+        } else if(strcmp(argv[arg], "--cache")==0 && arg+1<argc) {
+            cachePath = argv[++arg];
+        } else if(strcmp(argv[arg], "--table")==0 && arg+1<argc) {
+            tables.push_back(strtoul(argv[++arg], NULL, 0));
+        } else if(strcmp(argv[arg], "--grep")==0 && arg+1<argc) {
+            grepPattern = argv[++arg];
+        } else if(strcmp(argv[arg], "--budget")==0 && arg+1<argc) {
+            budget = strtoul(argv[++arg], NULL, 0);
+        } else if(strcmp(argv[arg], "--stats")==0 && arg+1<argc) {
+            statsPath = argv[++arg];
+        } else if(strcmp(argv[arg], "--threads")==0 && arg+1<argc) {
+            threads = atoi(argv[++arg]);
+        } else {
+            arg = argc;
+        }
+    }
+
+    if(arg>=argc || (diff && arg+1>=argc)) {
         cerr << "Missing .oa file as the only parameter." << endl;
-        cerr << "Usage: ./testParser /path/to/file.oa" << endl;
+        cerr << "Usage: ./testParser [--mmap] /path/to/file.oa" << endl;
+        cerr << "       ./testParser --stream /path/to/file.oa | -" << endl;
+        cerr << "       ./testParser --parallel [--threads N] /path/to/file.oa" << endl;
+        cerr << "       ./testParser --table ID [--table ID ...] /path/to/file.oa" <<
+             endl;
+        cerr << "       ./testParser --audit /path/to/file.oa" << endl;
+        cerr << "       ./testParser --diff /path/to/old.oa /path/to/new.oa" << endl;
+        cerr << "       ./testParser --cache /path/to/cache /path/to/file.oa" << endl;
+        cerr << "       ./testParser --rewrite /path/to/copy.oa /path/to/file.oa" << endl;
+        cerr << "       ./testParser --scan [--threads N] [--mmap | --audit | --cache FILE]" <<
+             endl;
+        cerr << "                    /path/to/library" << endl;
+        cerr << "       ./testParser --async [--depth N] /path/to/library" << endl;
+        cerr << "       ./testParser --watch [--threads N] /path/to/library" << endl;
+        cerr << "       ./testParser --grep TEXT [--threads N] /path/to/library" << endl;
+        cerr << "       ./testParser --verify [--threads N] /path/to/library" << endl;
+        cerr << "Add --budget BYTES to read large tables in chunks of at most BYTES," << endl;
+        cerr << "--data to also list the data tables of each file," << endl;
+        cerr << "--json for one JSON record per file (NDJSON with --scan)," << endl;
+        cerr << "and --stats FILE | - to write parse counters as JSON." << endl;
         return 1;
     }
 
-    MyTestParser parser;
-    return parser.parse(argv[1]);
+    if(diff) {
+        return diffFiles(argv[arg], argv[arg + 1]);
+    }
+
+    if(rewritePath!=NULL) {
+        MyRewriteParser parser;
+
+        if(parser.rewrite(argv[arg], rewritePath)!=0) {
+            cerr << "Unable to rewrite " << argv[arg] << endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Like grep, 0 if anything matched, 1 if nothing did.
+    if(grepPattern!=NULL) {
+        MyGrepScanner scanner(threads, grepPattern);
+
+        if(scanner.scan(argv[arg])<0) {
+            cerr << "Unable to read " << argv[arg] << endl;
+            return 2;
+        }
+
+        fflush(stdout);
+        return scanner.matchedFiles>0 ? 0 : 1;
+    }
+
+    // 0 if every file is sound, 1 if any is not.
+    if(verify) {
+        MyVerifyScanner scanner(threads);
+
+        if(scanner.scan(argv[arg])<0) {
+            cerr << "Unable to read " << argv[arg] << endl;
+            return 2;
+        }
+
+        cout << flush;
+        return scanner.failures==0 ? 0 : 1;
+    }
+
+    if(watch) {
+        MyLibraryWatcher watcher(threads);
+        activeWatcher = &watcher;
+        signal(SIGINT, stopWatching);
+        signal(SIGTERM, stopWatching);
+        int status = watcher.watch(argv[arg]);
+        activeWatcher = NULL;
+        return status;
+    }
+
+    oafp::oaParseCache cache;
+
+    if(cachePath!=NULL && cache.load(cachePath)!=0) {
+        cerr << "Ignoring unreadable cache " << cachePath << endl;
+    }
+
+    oafp::oaParseStats stats;
+    oafp::oaOutputBuffer jsonOut(1);
+    int status;
+
+    if(scan) {
+        MyLibraryScanner scanner(threads, mapped, audit && !json,
+                                 cachePath!=NULL ? &cache : NULL, statsPath!=NULL,
+                                 json ? &jsonOut : NULL);
+        status = scanner.scan(argv[arg])==0 ? 0 : 1;
+        scanner.mergeStats(stats);
+
+        if(cachePath!=NULL) {
+            cache.prune();
+            cache.save(cachePath);
+        }
+    } else if(async) {
+        vector<string> files;
+
+        if(oafp::findLibraryFiles(argv[arg], files)!=0) {
+            cerr << "Unable to read " << argv[arg] << endl;
+            return 2;
+        }
+
+        MyBatchParser parser;
+        parser.setDataTables(data);
+
+        if(statsPath!=NULL) {
+            parser.setStats(&stats);
+        }
+
+        status = parser.parseFiles(files, depth)==0 ? 0 : 1;
+    } else if(json) {
+        MyJsonParser parser(jsonOut);
+
+        if(statsPath!=NULL) {
+            parser.setStats(&stats);
+        }
+
+        parser.beginRecord(argv[arg]);
+        status = runParser(parser, argv[arg], tables, cachePath, cache, mapped,
+                           stream, parallel, threads);
+        parser.endRecord(status);
+    } else if(audit) {
+        MyAuditParser parser;
+        status = parser.audit(argv[arg]);
+    } else {
+        MyTestParser parser;
+        parser.setDataTables(data);
+        parser.setBufferBudget(budget);
+
+        if(statsPath!=NULL) {
+            parser.setStats(&stats);
+        }
+
+        status = runParser(parser, argv[arg], tables, cachePath, cache, mapped,
+                           stream, parallel, threads);
+    }
+
+    jsonOut.flush();
+
+    if(statsPath!=NULL) {
+        FILE *out = strcmp(statsPath, "-")==0 ? stdout : fopen(statsPath, "w");
+
+        if(out==NULL) {
+            cerr << "Unable to write " << statsPath << endl;
+            return 1;
+        }
+
+        cout << flush;
+        stats.dump(out);
+
+        if(out!=stdout) {
+            fclose(out);
+        }
+    }
+
+    return status;
 }
 
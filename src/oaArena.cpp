@@ -0,0 +1,138 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaArena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace oafp
+{
+    oaArena::oaArena(size_t blockSize)
+        : blockSize(blockSize), current(0), offset(0), before(0)
+    {
+    }
+
+    oaArena::~oaArena()
+    {
+        for(size_t i=0; i<blocks.size(); ++i) {
+            free(blocks[i].data);
+        }
+    }
+
+    void *oaArena::allocate(size_t size, size_t align)
+    {
+        if(size>(size_t)-1 - align) {
+            throw std::bad_alloc();
+        }
+
+        while(current<blocks.size()) {
+            block &b = blocks[current];
+            size_t start = (offset + align - 1) & ~(align - 1);
+
+            if(start<=b.size && size<=b.size - start) {
+                offset = start + size;
+                return b.data + start;
+            }
+
+            // Blocks are only ever skipped forward, so mark() stays valid.
+            before += b.size;
+            offset = 0;
+            ++current;
+        }
+
+        block b;
+        b.size = size + align>blockSize ? size + align : blockSize;
+        b.data = (char *)malloc(b.size);
+
+        if(b.data==NULL) {
+            throw std::bad_alloc();
+        }
+
+        blocks.push_back(b);
+        size_t start = ((size_t)b.data + align - 1) & ~(align - 1);
+        offset = start - (size_t)b.data + size;
+        return (void *)start;
+    }
+
+    size_t oaArena::mark() const
+    {
+        return before + offset;
+    }
+
+    void oaArena::rewind(size_t mark)
+    {
+        current = 0;
+        before = 0;
+
+        while(current + 1<blocks.size() && mark>=before + blocks[current].size) {
+            before += blocks[current].size;
+            ++current;
+        }
+
+        offset = mark - before;
+    }
+
+    void oaArena::reset()
+    {
+        if(blocks.size()>1) {
+            size_t total = capacity();
+
+            for(size_t i=0; i<blocks.size(); ++i) {
+                free(blocks[i].data);
+            }
+
+            blocks.clear();
+            block b;
+            b.size = total;
+            b.data = (char *)malloc(b.size);
+
+            if(b.data==NULL) {
+                throw std::bad_alloc();
+            }
+
+            blocks.push_back(b);
+        }
+
+        current = 0;
+        offset = 0;
+        before = 0;
+    }
+
+    size_t oaArena::capacity() const
+    {
+        size_t total = 0;
+
+        for(size_t i=0; i<blocks.size(); ++i) {
+            total += blocks[i].size;
+        }
+
+        return total;
+    }
+
+    size_t oaArena::used() const
+    {
+        return mark();
+    }
+} //End namespace oafp
@@ -0,0 +1,409 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaAsyncIO.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+namespace oafp
+{
+    static const unsigned int maxPoolThreads = 16;
+
+    // A minimal io_uring driven through the raw system calls.  Every read
+    // owns one of depth slots and has at most one vectored read queued, so
+    // the submission queue never fills.
+    class oaAsyncIO::ring
+    {
+    public:
+        ring()
+            : fd(-1), sqMap(MAP_FAILED), cqMap(MAP_FAILED), sqes(MAP_FAILED),
+              sqSize(0), cqSize(0), sqesSize(0), unsubmitted(0) {
+        };
+        ~ring() {
+            if(sqes!=MAP_FAILED) {
+                munmap(sqes, sqesSize);
+            }
+
+            if(cqMap!=MAP_FAILED && cqMap!=sqMap) {
+                munmap(cqMap, cqSize);
+            }
+
+            if(sqMap!=MAP_FAILED) {
+                munmap(sqMap, sqSize);
+            }
+
+            if(fd>=0) {
+                ::close(fd);
+            }
+        };
+
+        // Returns false if the kernel offers no io_uring.
+        bool open(unsigned int entries) {
+            struct io_uring_params p;
+            memset(&p, 0, sizeof(p));
+            fd = syscall(__NR_io_uring_setup, entries, &p);
+
+            if(fd<0) {
+                return false;
+            }
+
+            sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+            cqSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+            if(p.features & IORING_FEAT_SINGLE_MMAP) {
+                sqSize = cqSize = std::max(sqSize, cqSize);
+            }
+
+            sqMap = mmap(NULL, sqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         fd, IORING_OFF_SQ_RING);
+
+            if(sqMap==MAP_FAILED) {
+                return false;
+            }
+
+            if(p.features & IORING_FEAT_SINGLE_MMAP) {
+                cqMap = sqMap;
+            } else {
+                cqMap = mmap(NULL, cqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                             fd, IORING_OFF_CQ_RING);
+
+                if(cqMap==MAP_FAILED) {
+                    return false;
+                }
+            }
+
+            sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+            sqes = mmap(NULL, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        fd, IORING_OFF_SQES);
+
+            if(sqes==MAP_FAILED) {
+                return false;
+            }
+
+            char *sq = (char *)sqMap;
+            char *cq = (char *)cqMap;
+            sqTail = (unsigned int *)(sq + p.sq_off.tail);
+            sqMask = *(unsigned int *)(sq + p.sq_off.ring_mask);
+            sqArray = (unsigned int *)(sq + p.sq_off.array);
+            cqHead = (unsigned int *)(cq + p.cq_off.head);
+            cqTail = (unsigned int *)(cq + p.cq_off.tail);
+            cqMask = *(unsigned int *)(cq + p.cq_off.ring_mask);
+            cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+            slots.resize(entries);
+            vectors.resize(entries);
+            done.resize(entries);
+
+            for(unsigned int s=entries; s>0; --s) {
+                freeSlots.push_back(s - 1);
+            }
+
+            return true;
+        };
+
+        // Queues r; returns false if all slots are taken.
+        bool submit(const asyncRead &r) {
+            if(freeSlots.empty()) {
+                return false;
+            }
+
+            unsigned int s = freeSlots.back();
+            freeSlots.pop_back();
+            slots[s] = r;
+            done[s] = 0;
+            push(s);
+            return true;
+        };
+
+        // Submits the queued reads and waits until at least one read has
+        // completed in full.
+        void reap(std::vector<asyncRead> &finished) {
+            size_t before = finished.size();
+
+            while(true) {
+                unsigned int head = *cqHead;
+                unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+                for(; head!=tail; ++head) {
+                    struct io_uring_cqe &cqe = cqes[head & cqMask];
+                    completed(cqe.user_data, cqe.res, finished);
+                }
+
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+                if(finished.size()>before && unsubmitted==0) {
+                    return;
+                }
+
+                enter(finished.size()>before ? 0 : 1);
+            }
+        };
+
+    private:
+        void push(unsigned int s) {
+            unsigned int tail = *sqTail;
+            unsigned int index = tail & sqMask;
+            struct io_uring_sqe &sqe = ((struct io_uring_sqe *)sqes)[index];
+            vectors[s].iov_base = slots[s].buffer + done[s];
+            vectors[s].iov_len = slots[s].len - done[s];
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = slots[s].fd;
+            sqe.off = slots[s].offset + done[s];
+            sqe.addr = (unsigned long)&vectors[s];
+            sqe.len = 1;
+            sqe.user_data = s;
+            sqArray[index] = index;
+            __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+            ++unsubmitted;
+        };
+
+        void enter(unsigned int wait) {
+            long in = syscall(__NR_io_uring_enter, fd, unsubmitted, wait,
+                              wait>0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+
+            if(in>0) {
+                unsubmitted -= in;
+            }
+        };
+
+        // Resumes a short read, or hands the read back once it is whole.
+        void completed(unsigned int s, int res, std::vector<asyncRead> &finished) {
+            asyncRead &r = slots[s];
+
+            if(res==-EINTR || res==-EAGAIN || (res>0 && done[s] + res<r.len)) {
+                done[s] += std::max(res, 0);
+                push(s);
+                return;
+            }
+
+            r.result = res<0 ? res : (long)(done[s] + res);
+            finished.push_back(r);
+            freeSlots.push_back(s);
+        };
+
+        int                             fd;
+        void                           *sqMap;
+        void                           *cqMap;
+        void                           *sqes;
+        size_t                          sqSize;
+        size_t                          cqSize;
+        size_t                          sqesSize;
+        unsigned int                   *sqTail;
+        unsigned int                    sqMask;
+        unsigned int                   *sqArray;
+        unsigned int                   *cqHead;
+        unsigned int                   *cqTail;
+        unsigned int                    cqMask;
+        struct io_uring_cqe            *cqes;
+        unsigned int                    unsubmitted;
+        std::vector<asyncRead>          slots;
+        std::vector<struct iovec>       vectors;
+        std::vector<unsigned long>      done;
+        std::vector<unsigned int>       freeSlots;
+    };
+
+    // The fallback: threads that each run one blocking pread at a time.
+    class oaAsyncIO::pool
+    {
+    public:
+        pool(unsigned int numThreads)
+            : stopping(false) {
+            for(unsigned int i=0; i<numThreads; ++i) {
+                threads.push_back(std::thread([this]() {
+                    work();
+                }));
+            }
+        };
+        ~pool() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+
+            queued.notify_all();
+
+            for(size_t i=0; i<threads.size(); ++i) {
+                threads[i].join();
+            }
+        };
+
+        void submit(const asyncRead &r) {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                tasks.push_back(r);
+            }
+
+            queued.notify_one();
+        };
+        void reap(std::vector<asyncRead> &finished) {
+            std::unique_lock<std::mutex> guard(lock);
+            completed.wait(guard, [this]() {
+                return !results.empty();
+            });
+            finished.insert(finished.end(), results.begin(), results.end());
+            results.clear();
+        };
+
+    private:
+        void work() {
+            while(true) {
+                asyncRead r;
+
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    queued.wait(guard, [this]() {
+                        return stopping || !tasks.empty();
+                    });
+
+                    if(stopping) {
+                        return;
+                    }
+
+                    r = tasks.front();
+                    tasks.pop_front();
+                }
+
+                unsigned long got = 0;
+                r.result = 0;
+
+                while(got<r.len) {
+                    ssize_t in = pread(r.fd, r.buffer + got, r.len - got, r.offset + got);
+
+                    if(in<0 && errno==EINTR) {
+                        continue;
+                    }
+
+                    if(in<=0) {
+                        r.result = in<0 ? -errno : 0;
+                        break;
+                    }
+
+                    got += in;
+                }
+
+                if(r.result==0) {
+                    r.result = got;
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    results.push_back(r);
+                }
+
+                completed.notify_one();
+            }
+        };
+
+        bool                        stopping;
+        std::deque<asyncRead>       tasks;
+        std::vector<asyncRead>      results;
+        std::mutex                  lock;
+        std::condition_variable     queued;
+        std::condition_variable     completed;
+        std::vector<std::thread>    threads;
+    };
+
+    oaAsyncIO::oaAsyncIO(unsigned int depth, bool useRing)
+        : depth(std::max(depth, 1u)), inFlight(0), uring(NULL), threads(NULL)
+    {
+        if(useRing) {
+            uring = new ring;
+
+            if(!uring->open(this->depth)) {
+                delete uring;
+                uring = NULL;
+            }
+        }
+
+        if(uring==NULL) {
+            threads = new pool(std::min(this->depth, maxPoolThreads));
+        }
+    }
+
+    oaAsyncIO::~oaAsyncIO()
+    {
+        delete uring;
+        delete threads;
+    }
+
+    bool oaAsyncIO::isRing() const
+    {
+        return uring!=NULL;
+    }
+
+    void oaAsyncIO::read(int fd, unsigned long offset, char *buffer,
+                         unsigned long len, unsigned long tag)
+    {
+        asyncRead r = {fd, offset, buffer, len, tag, 0};
+        queued.push_back(r);
+    }
+
+    size_t oaAsyncIO::complete(std::vector<asyncRead> &done)
+    {
+        size_t before = done.size();
+
+        while(!queued.empty() && inFlight<depth) {
+            if(uring!=NULL) {
+                if(!uring->submit(queued.front())) {
+                    break;
+                }
+            } else {
+                threads->submit(queued.front());
+            }
+
+            queued.pop_front();
+            ++inFlight;
+        }
+
+        if(inFlight==0) {
+            return 0;
+        }
+
+        if(uring!=NULL) {
+            uring->reap(done);
+        } else {
+            threads->reap(done);
+        }
+
+        inFlight -= done.size() - before;
+        return done.size() - before;
+    }
+
+    size_t oaAsyncIO::outstanding() const
+    {
+        return queued.size() + inFlight;
+    }
+} //End namespace oafp
@@ -0,0 +1,197 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaDatabaseMap.h"
+
+#include <algorithm>
+
+namespace oafp
+{
+    oaDatabaseMap::oaDatabaseMap()
+        : typesIndexed(false)
+    {
+    }
+
+    void oaDatabaseMap::assign(const unsigned long ids[],
+                               const unsigned int types[], unsigned int idCount,
+                               const unsigned long tblIds[], const unsigned int tblTypes[],
+                               unsigned int tblCount)
+    {
+        startMap();
+        appendMap(ids, types, idCount, false);
+        appendMap(tblIds, tblTypes, tblCount, true);
+        finishMap();
+    }
+
+    void oaDatabaseMap::startMap()
+    {
+        base.clear();
+    }
+
+    void oaDatabaseMap::appendMap(const unsigned long ids[],
+                                  const unsigned int types[], unsigned long num, bool dataTable)
+    {
+        add(base, ids, types, num, dataTable ? 1 : 0);
+    }
+
+    void oaDatabaseMap::finishMap()
+    {
+        merge();
+    }
+
+    void oaDatabaseMap::applyDelta(const unsigned long ids[],
+                                   const unsigned int types[], unsigned long num)
+    {
+        add(delta, ids, types, num, 1);
+        merge();
+    }
+
+    void oaDatabaseMap::clear()
+    {
+        base.clear();
+        delta.clear();
+        merge();
+    }
+
+    unsigned int oaDatabaseMap::count() const
+    {
+        return idColumn.size();
+    }
+
+    const unsigned long *oaDatabaseMap::ids() const
+    {
+        return idColumn.data();
+    }
+
+    const unsigned int *oaDatabaseMap::types() const
+    {
+        return typeColumn.data();
+    }
+
+    bool oaDatabaseMap::isDataTable(unsigned int i) const
+    {
+        return dataTableColumn[i]!=0;
+    }
+
+    int oaDatabaseMap::find(unsigned long id) const
+    {
+        std::vector<unsigned long>::const_iterator it = std::lower_bound(
+                    idColumn.begin(), idColumn.end(), id);
+
+        if(it==idColumn.end() || *it!=id) {
+            return -1;
+        }
+
+        return it - idColumn.begin();
+    }
+
+    bool oaDatabaseMap::findType(unsigned long id, unsigned int &type) const
+    {
+        int i = find(id);
+
+        if(i<0) {
+            return false;
+        }
+
+        type = typeColumn[i];
+        return true;
+    }
+
+    unsigned int oaDatabaseMap::findIds(unsigned int type,
+                                        const unsigned long *&ids) const
+    {
+        if(!typesIndexed) {
+            indexTypes();
+        }
+
+        std::pair<std::vector<unsigned int>::const_iterator,
+            std::vector<unsigned int>::const_iterator> range = std::equal_range(
+                        byTypeTypes.begin(), byTypeTypes.end(), type);
+        ids = byTypeIds.data() + (range.first - byTypeTypes.begin());
+        return range.second - range.first;
+    }
+
+    void oaDatabaseMap::add(std::vector<entry> &to, const unsigned long ids[],
+                            const unsigned int types[], unsigned long num,
+                            unsigned int dataTable)
+    {
+        for(unsigned long i=0; i<num; ++i) {
+            entry e = {ids[i], types[i], dataTable};
+            to.push_back(e);
+        }
+    }
+
+    // Sorts the map and delta entries by id into the columns.  The sort is
+    // stable, so of several entries with one id the one added last wins.
+    void oaDatabaseMap::merge()
+    {
+        merged.assign(base.begin(), base.end());
+        merged.insert(merged.end(), delta.begin(), delta.end());
+        std::stable_sort(merged.begin(), merged.end(),
+        [](const entry &a, const entry &b) {
+            return a.id<b.id;
+        });
+
+        idColumn.clear();
+        typeColumn.clear();
+        dataTableColumn.clear();
+        typesIndexed = false;
+
+        for(size_t i=0; i<merged.size(); ++i) {
+            if(i+1<merged.size() && merged[i + 1].id==merged[i].id) {
+                continue;
+            }
+
+            idColumn.push_back(merged[i].id);
+            typeColumn.push_back(merged[i].type);
+            dataTableColumn.push_back(merged[i].dataTable);
+        }
+    }
+
+    void oaDatabaseMap::indexTypes() const
+    {
+        std::vector<unsigned int> order(idColumn.size());
+
+        for(unsigned int i=0; i<order.size(); ++i) {
+            order[i] = i;
+        }
+
+        // Positions are already in id order, so a stable sort by type keeps
+        // the ids of each type sorted.
+        std::stable_sort(order.begin(), order.end(),
+        [this](unsigned int a, unsigned int b) {
+            return typeColumn[a]<typeColumn[b];
+        });
+
+        byTypeTypes.resize(order.size());
+        byTypeIds.resize(order.size());
+
+        for(size_t i=0; i<order.size(); ++i) {
+            byTypeTypes[i] = typeColumn[order[i]];
+            byTypeIds[i] = idColumn[order[i]];
+        }
+
+        typesIndexed = true;
+    }
+} //End namespace oafp
@@ -30,223 +30,1628 @@
  */
 
 #include "oaFileParser.h"
+#include "oaAsyncIO.h"
+#include "oaDatabaseMap.h"
+#include "oaParseCache.h"
+#include "oaParseStats.h"
+#include "oaStringTable.h"
+#include "oaTableDecoders.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 namespace oafp
 {
-    unsigned long roundAlign8Bit(unsigned long len)
+    static unsigned long findStartOffset(unsigned long ids[],
+                                         unsigned long offsets[], unsigned int num)
     {
-        unsigned long rem = len%8;
-        return len + (8 - rem);
+        for(unsigned int i=0; i<num; ++i) {
+            if(ids[i]==1) {
+                return offsets[i];
+            }
+        }
+
+        return 0;
     }
 
-    void oaFileParser::read0x04(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
+    oaFdReader::oaFdReader(int fd)
+        : fd(fd)
     {
-        fseek(file, pos, SEEK_SET);
-        unsigned int flags = 0;
-        unsigned int in = 0;
-        in = fread(&flags, sizeof(flags), 1, file);
-        onParsedFlags(flags);
     }
 
-    void oaFileParser::read0x05(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
+    long oaFdReader::read(void *buffer, unsigned long len)
     {
-        fseek(file, pos, SEEK_SET);
-        unsigned int timeStamp;
-        unsigned int in = 0;
-        in = fread(&timeStamp, sizeof(timeStamp), 1, file);
-        onParsedTimeStamp(timeStamp);
+        ssize_t in;
+
+        do {
+            in = ::read(fd, buffer, len);
+        } while(in<0 && errno==EINTR);
+
+        return in;
     }
 
-    void oaFileParser::read0x06(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
+    tableDirectory::tableDirectory()
+        : ids(NULL), offsets(NULL), sizes(NULL), startOffset(0), fileSize(0), fd(-1)
     {
-        fseek(file, pos, SEEK_SET);
-        unsigned long lsTime;
-        unsigned int in = 0;
-        in = fread(&lsTime, sizeof(lsTime), 1, file);
-        onParsedLastSavedTime(lsTime);
+        memset(&header, 0, sizeof(header));
     }
 
-    void oaFileParser::read0x07(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
+    tableDirectory::~tableDirectory()
     {
-        fseek(file, pos, SEEK_SET);
-        unsigned int numRes;
-        unsigned int numData;
-        unsigned int in = 0;
-        in = fread(&numRes, sizeof(numRes), 1, file);
-        in = fread(&numData, sizeof(numData), 1, file);
-        unsigned int numOther = numData - numRes;
-        unsigned long ids[numRes];
-        unsigned int types[numRes];
-        unsigned long tblIds[numOther];
-        unsigned int tblTypes[numOther];
-        in = fread(&ids[0], sizeof(ids[0]) * numRes, 1, file);
-        in = fread(&types[0], sizeof(types[0]) * numRes, 1, file);
-        in = fread(&tblIds[0], sizeof(tblIds[0]) * numOther, 1, file);
-        in = fread(&tblTypes[0], sizeof(tblTypes[0]) * numOther, 1, file);
-        onParsedDatabaseMap(ids, types, numRes, tblIds, tblTypes, numOther);
+        close();
     }
 
-    void oaFileParser::read0x0a(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
+    void tableDirectory::close()
     {
-        fseek(file, pos, SEEK_SET);
-        char buffer[tblSize];
-        tableIndex table;
-        unsigned int empty;
-        unsigned int in = 0;
-        in = fread(&table, sizeof(table), 1, file);
-        in = fread(&empty, sizeof(empty), 1, file);
-        in = fread(&buffer, sizeof(buffer), 1, file);
-        onParsedStringTable(table, buffer);
-    }
-
-    void oaFileParser::read0x19(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
-    {
-        fseek(file, pos, SEEK_SET);
-        unsigned long createTime;
-        unsigned int in = 0;
-        in = fread(&createTime, sizeof(createTime), 1, file);
-        onParsedCreateTime(createTime);
-    }
-
-    void oaFileParser::read0x1c(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
-    {
-        fseek(file, pos, SEEK_SET);
-        unsigned short dataModelRev;
-        char buildName[tblSize - sizeof(dataModelRev)];
-        unsigned int in = 0;
-        in = fread(&dataModelRev, sizeof(dataModelRev), 1, file);
-        in = fread(&buildName, sizeof(buildName), 1, file);
-        onParsedDMandBuildName(dataModelRev, buildName);
-    }
-
-    void oaFileParser::read0x1d(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
-    {
-        fseek(file, pos, SEEK_SET);
-        appInfo ai;
-        char buffer[tblSize - (sizeof(unsigned short)*4)];
-        char *appBuildName;
-        char *kitBuildName;
-        char *platforName;
-        unsigned int in = 0;
-        in = fread(&ai, sizeof(ai), 1, file);
-        in = fread(&buffer, sizeof(buffer), 1, file);
-        unsigned int b = 0;
-        appBuildName = &buffer[b];
-        b += roundAlign8Bit(strlen(appBuildName));
-        kitBuildName = &buffer[b];
-        b += roundAlign8Bit(strlen(kitBuildName));
-        platforName = &buffer[b];
-        onParsedBuildInformation(ai.appDataModelRev, ai.kitDataModelRev,
-                                 ai.appAPIMinorRev, ai.kitReleaseNum,
-                                 appBuildName, kitBuildName, platforName);
-    }
-
-    void oaFileParser::read0x1f(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
-    {
-        fseek(file, pos, SEEK_SET);
-        unsigned long num;
-        unsigned int in = 0;
-        in = fread(&num, sizeof(num), 1, file);
-        unsigned long ids[num];
-        unsigned int types[num];
-        in = fread(&ids[0], sizeof(ids[0]) * num, 1, file);
-        in = fread(&types[0], sizeof(types[0]) * num, 1, file);
-        onParsedDatabaseMapD(ids, types, num);
-    }
-
-    void oaFileParser::read0x28(FILE *file, unsigned long pos,
-                                unsigned long tblSize)
-    {
-        fseek(file, pos, SEEK_SET);
-        unsigned int bitCheck;
-        unsigned int in = 0;
-        in = fread(&bitCheck, sizeof(bitCheck), 1, file);
-        onParsedDatabaseMarker(bitCheck);
+        if(fd>=0) {
+            ::close(fd);
+            fd = -1;
+        }
+
+        header.used = 0;
+    }
+
+    int tableDirectory::open(const char *filePath)
+    {
+        close();
+        fd = ::open(filePath, O_RDONLY);
+
+        if(fd<0) {
+            return -1;
+        }
+
+        struct stat st;
+        ssize_t in;
+
+        if(fstat(fd, &st)!=0 || (in = pread(fd, &header, sizeof(header), 0))<0) {
+            close();
+            return -1;
+        }
+
+        if(in!=sizeof(header)) {
+            close();
+            return 1;
+        }
+
+        fileSize = st.st_size;
+        unsigned long used = header.used;
+        ssize_t indexSize = sizeof(unsigned long) * used * 3;
+
+        if(used > (fileSize - sizeof(header)) / (sizeof(unsigned long) * 3)) {
+            close();
+            return 1;
+        }
+
+        index.resize(used * 3);
+        in = pread(fd, index.data(), indexSize, sizeof(header));
+
+        if(in!=indexSize) {
+            close();
+            return in<0 ? -1 : 1;
+        }
+
+        ids = index.data();
+        offsets = ids + used;
+        sizes = offsets + used;
+        startOffset = findStartOffset(ids, offsets, used);
+        return 0;
+    }
+
+    int tableDirectory::read(unsigned int i, char *buffer) const
+    {
+        unsigned long pos = position(i);
+
+        if(fd<0 || pos>fileSize || sizes[i]>fileSize - pos) {
+            return 1;
+        }
+
+        return pread(fd, buffer, sizes[i], pos)==(ssize_t)sizes[i] ? 0 : 1;
+    }
+
+    int tableDirectory::read(unsigned int i, unsigned long offset, char *buffer,
+                             unsigned long len) const
+    {
+        unsigned long pos = position(i);
+
+        if(fd<0 || offset>sizes[i] || len>sizes[i] - offset || pos>fileSize ||
+           offset + len>fileSize - pos) {
+            return 1;
+        }
+
+        return pread(fd, buffer, len, pos + offset)==(ssize_t)len ? 0 : 1;
+    }
+
+    int tableDirectory::find(unsigned long id) const
+    {
+        for(unsigned int i=0; i<header.used; ++i) {
+            if(ids[i]==id) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    int tableDirectory::map(unsigned int i, tableMapping &mapping) const
+    {
+        unsigned long pos = position(i);
+
+        if(fd<0 || pos>fileSize || sizes[i]>fileSize - pos) {
+            return 1;
+        }
+
+        unsigned long page = sysconf(_SC_PAGESIZE);
+        unsigned long start = pos & ~(page - 1);
+        mapping.length = pos - start + sizes[i];
+        mapping.addr = mmap(NULL, std::max(mapping.length, 1UL), PROT_READ,
+                            MAP_PRIVATE, fd, start);
+
+        if(mapping.addr==MAP_FAILED) {
+            mapping.addr = NULL;
+            return 1;
+        }
+
+        mapping.data = (const char *)mapping.addr + (pos - start);
+        mapping.size = sizes[i];
+        return 0;
+    }
+
+    void tableDirectory::unmap(tableMapping &mapping)
+    {
+        if(mapping.addr!=NULL) {
+            munmap(mapping.addr, std::max(mapping.length, 1UL));
+            mapping.addr = NULL;
+        }
+    }
+
+    unsigned long tableDirectory::position(unsigned int i) const
+    {
+        return tablePosition(ids[i], offsets[i], startOffset);
+    }
+
+    oaFileParser::oaFileParser()
+        : mapData(NULL), mapSize(0), arena(&ownArena), strings(NULL), stats(NULL),
+          dbMap(NULL), userMap(NULL), ownMap(NULL), dataTables(false),
+          bufferBudget(0)
+    {
+    }
+
+    oaFileParser::~oaFileParser()
+    {
+        releaseMapping();
+        delete strings;
+        delete ownMap;
+    }
+
+    void oaFileParser::setArena(oaArena *arena)
+    {
+        this->arena = arena!=NULL ? arena : &ownArena;
+    }
+
+    void oaFileParser::setIndexStrings(bool indexStrings)
+    {
+        if(!indexStrings) {
+            delete strings;
+            strings = NULL;
+        } else if(strings==NULL) {
+            strings = new oaStringTable();
+        }
+    }
+
+    void oaFileParser::setDataTables(bool dataTables)
+    {
+        // Data table types come from the database map, so one is kept even
+        // if the caller did not set their own.
+        this->dataTables = dataTables;
+
+        if(!dataTables) {
+            delete ownMap;
+            ownMap = NULL;
+        } else if(ownMap==NULL) {
+            ownMap = new oaDatabaseMap();
+        }
+
+        dbMap = userMap!=NULL ? userMap : ownMap;
+    }
+
+    void oaFileParser::setBufferBudget(unsigned long bytes)
+    {
+        bufferBudget = bytes==0 ? 0 : std::max(bytes, minBufferBudget);
+    }
+
+    void oaFileParser::setDatabaseMap(oaDatabaseMap *map)
+    {
+        userMap = map;
+        dbMap = userMap!=NULL ? userMap : ownMap;
+    }
+
+    // Collects data tables for onParsedDataTables().  Every table is
+    // announced with room() or, when its data is to be read, reserve(),
+    // which flush the batch first if the table would overflow it, and then
+    // passed to add().  All of a batch lives in the arena above the mark
+    // taken for its first table and is released by flush().
+    class oaFileParser::dataBatch
+    {
+    public:
+        dataBatch(oaFileParser &parser)
+            : parser(parser), mark(0), num(0), bytes(0), ids(NULL), types(NULL),
+              sizes(NULL), data(NULL) {
+        };
+
+        void room(unsigned long size) {
+            if(num>0 && size>dataBatchBytes - std::min(bytes, dataBatchBytes)) {
+                flush();
+            }
+
+            if(num==0) {
+                start();
+            }
+        };
+        char *reserve(unsigned long size) {
+            room(size);
+
+            // One spare byte keeps trailing names terminated.
+            char *buffer = parser.arena->allocate<char>(size + 1);
+            buffer[size] = '\0';
+            return buffer;
+        };
+        void add(unsigned long id, unsigned long size, const char *buffer) {
+            ids[num] = id;
+            sizes[num] = size;
+            data[num] = buffer;
+            bytes += size;
+
+            if(++num==dataBatchTables) {
+                flush();
+            }
+        };
+        void flush();
+        bool empty() const {
+            return num==0;
+        };
+
+    private:
+        void start() {
+            mark = parser.arena->mark();
+            ids = parser.arena->allocate<unsigned long>(dataBatchTables);
+            types = parser.arena->allocate<unsigned int>(dataBatchTables);
+            sizes = parser.arena->allocate<unsigned long>(dataBatchTables);
+            data = parser.arena->allocate<const char *>(dataBatchTables);
+        };
+
+        oaFileParser       &parser;
+        size_t              mark;
+        unsigned int        num;
+        unsigned long       bytes;
+        unsigned long      *ids;
+        unsigned int       *types;
+        unsigned long      *sizes;
+        const char        **data;
+    };
+
+    void oaFileParser::dataBatch::flush()
+    {
+        if(num==0) {
+            return;
+        }
+
+        for(unsigned int i=0; i<num; ++i) {
+            if(parser.dbMap==NULL || !parser.dbMap->findType(ids[i], types[i])) {
+                types[i] = dataTableBatch::unknownType;
+            }
+        }
+
+        dataTableBatch batch = {num, ids, types, sizes, data, bytes};
+        parser.onParsedDataTables(batch);
+        parser.arena->rewind(mark);
+        num = 0;
+        bytes = 0;
+    }
+
+    void oaFileParser::setStats(oaParseStats *stats)
+    {
+        this->stats = stats;
+    }
+
+    // Brackets one parse for the stats; failed() is called from the error
+    // paths.
+    class oaFileParser::statsScope
+    {
+    public:
+        statsScope(oaParseStats *stats, const char *filePath)
+            : stats(stats), status(0) {
+            if(stats!=NULL) {
+                stats->beginParse(filePath);
+            }
+        };
+        ~statsScope() {
+            if(stats!=NULL) {
+                stats->endParse(status);
+            }
+        };
+
+        void failed() {
+            status = 1;
+        };
+
+    private:
+        oaParseStats   *stats;
+        int             status;
+    };
+
+    double oaFileParser::statsClock() const
+    {
+        if(stats==NULL) {
+            return 0;
+        }
+
+        return std::chrono::duration<double>
+               (std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void oaFileParser::statsRead(unsigned long bytes, bool seek)
+    {
+        if(stats!=NULL) {
+            stats->addRead(bytes, seek);
+        }
+    }
+
+    void oaFileParser::statsTable(unsigned long id, unsigned long bytes,
+                                  double started)
+    {
+        if(stats!=NULL) {
+            stats->addTable(id, bytes, statsClock() - started);
+        }
+    }
+
+    void oaFileParser::releaseMapping()
+    {
+        if(mapData!=NULL) {
+            munmap(mapData, mapSize);
+            mapData = NULL;
+            mapSize = 0;
+        }
+    }
+
+    void oaFileParser::read0x04(char *data, unsigned long tblSize)
+    {
+        decode0x04(data, tblSize, [this](unsigned int flags) {
+            onParsedFlags(flags);
+        });
+    }
+
+    void oaFileParser::read0x05(char *data, unsigned long tblSize)
+    {
+        decode0x05(data, tblSize, [this](unsigned int timeStamp) {
+            onParsedTimeStamp(timeStamp);
+        });
+    }
+
+    void oaFileParser::read0x06(char *data, unsigned long tblSize)
+    {
+        decode0x06(data, tblSize, [this](unsigned long lsTime) {
+            onParsedLastSavedTime(lsTime);
+        });
+    }
+
+    void oaFileParser::read0x07(char *data, unsigned long tblSize)
+    {
+        decode0x07(data, tblSize, *arena, [this](unsigned long ids[],
+                   unsigned int types[], unsigned int idCount, unsigned long tblIds[],
+        unsigned int tblTypes[], unsigned int tblCount) {
+            if(dbMap!=NULL) {
+                dbMap->assign(ids, types, idCount, tblIds, tblTypes, tblCount);
+            }
+
+            onParsedDatabaseMap(ids, types, idCount, tblIds, tblTypes, tblCount);
+        });
+    }
+
+    void oaFileParser::read0x0a(char *data, unsigned long tblSize)
+    {
+        decode0x0a(data, tblSize, [this](tableIndex table, char *buffer,
+        unsigned long bufferSize) {
+            // parseMapped() hands over the mapping itself, with no spare
+            // byte behind it, so both paths check the size first.
+            if(table.used>bufferSize) {
+                throw("String table exceeds its table size.");
+            }
+
+            if(strings==NULL) {
+                onParsedStringTable(table, buffer);
+                return;
+            }
+
+            strings->build(table, buffer);
+            onParsedStringTableIndex(*strings);
+        });
+    }
+
+    void oaFileParser::read0x19(char *data, unsigned long tblSize)
+    {
+        decode0x19(data, tblSize, [this](unsigned long createTime) {
+            onParsedCreateTime(createTime);
+        });
+    }
+
+    void oaFileParser::read0x1c(char *data, unsigned long tblSize)
+    {
+        decode0x1c(data, tblSize, [this](unsigned short dataModelRev,
+        const char *buildName) {
+            onParsedDMandBuildName(dataModelRev, buildName);
+        });
+    }
+
+    void oaFileParser::read0x1d(char *data, unsigned long tblSize)
+    {
+        decode0x1d(data, tblSize, [this](unsigned short appDataModelRev,
+                   unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
+                   unsigned short kitReleaseNum, const char *appBuildName,
+        const char *kitBuildName, const char *platforName) {
+            onParsedBuildInformation(appDataModelRev, kitDataModelRev, appAPIMinorRev,
+                                     kitReleaseNum, appBuildName, kitBuildName, platforName);
+        });
+    }
+
+    void oaFileParser::read0x1f(char *data, unsigned long tblSize)
+    {
+        decode0x1f(data, tblSize, *arena, [this](unsigned long ids[],
+        unsigned int types[], unsigned long num) {
+            if(dbMap!=NULL) {
+                dbMap->applyDelta(ids, types, num);
+            }
+
+            onParsedDatabaseMapD(ids, types, num);
+        });
+    }
+
+    void oaFileParser::read0x28(char *data, unsigned long tblSize)
+    {
+        decode0x28(data, tblSize, [this](unsigned int bitCheck) {
+            onParsedDatabaseMarker(bitCheck);
+        });
+    }
+
+    bool oaFileParser::isKnownTable(unsigned long id)
+    {
+        switch((int)id) {
+            case 0x04:
+            case 0x05:
+            case 0x06:
+            case 0x07:
+            case 0x0a:
+            case 0x19:
+            case 0x1c:
+            case 0x1d:
+            case 0x1f:
+            case 0x28:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    bool oaFileParser::isDataTable(unsigned long id)
+    {
+        return id!=0x01 && !isKnownTable(id);
+    }
+
+    void oaFileParser::readTable(unsigned long id, char *data,
+                                 unsigned long tblSize)
+    {
+        switch((int)id) {
+            case 0x04: read0x04(data, tblSize);
+                break; //Flags??
+
+            case 0x05: read0x05(data, tblSize);
+                break; //Time stamp??
+
+            case 0x06: read0x06(data, tblSize);
+                break; //Last saved time
+
+            case 0x07: read0x07(data, tblSize);
+                break; //File mapping
+
+            case 0x19: read0x19(data, tblSize);
+                break; //Creation time
+
+            case 0x1c: read0x1c(data, tblSize);
+                break; //DM information and version numbers
+
+            case 0x1d: read0x1d(data, tblSize);
+                break; //Software build information
+
+            case 0x1f: read0x1f(data, tblSize);
+                break; //Data table map delta
+
+            case 0x28: read0x28(data, tblSize);
+                break; //End of database marker??
+
+            case 0x0a: read0x0a(data, tblSize);
+                break; //String table
+
+            default:
+                break;
+        }
     }
 
     int oaFileParser::parse(const char *filePath)
     {
+        FILE *file = NULL;
+        statsScope scope(stats, filePath);
+
         try {
             fileHeader fh;
-            FILE *file = fopen(filePath, "r");
+            file = fopen(filePath, "r");
 
             if(file==NULL) {
                 throw("File path does not exist.");
                 return 1;
             }
 
+            struct stat st;
+
+            if(fstat(fileno(file), &st)!=0) {
+                throw("Unable to read the file size.");
+            }
+
+            unsigned long fileSize = st.st_size;
             size_t in = fread(&fh, sizeof(fh), 1, file);
+            statsRead(sizeof(fh), false);
+
+            if(in!=1) {
+                throw("File is too small.");
+            }
+
             onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size, fh.used);
 
-            unsigned long ids[fh.used];
-            unsigned long offsets[fh.used];
-            unsigned long sizes[fh.used];
-            unsigned long startOffset = 0;
+            // Rejected before the index is allocated from the arena.
+            if(fh.used > (fileSize - sizeof(fh)) / (sizeof(unsigned long) * 3)) {
+                throw("Table index exceeds file size.");
+            }
+
+            arena->reset();
+
+            if(dbMap!=NULL) {
+                dbMap->clear();
+            }
+
+            unsigned long *ids = arena->allocate<unsigned long>(fh.used);
+            unsigned long *offsets = arena->allocate<unsigned long>(fh.used);
+            unsigned long *sizes = arena->allocate<unsigned long>(fh.used);
             in = fread(&ids[0], sizeof(ids[0]) * fh.used, 1, file);
             in = fread(&offsets[0], sizeof(offsets[0]) * fh.used, 1, file);
             in = fread(&sizes[0], sizeof(sizes[0]) * fh.used, 1, file);
+            statsRead(sizeof(ids[0]) * fh.used, false);
+            statsRead(sizeof(offsets[0]) * fh.used, false);
+            statsRead(sizeof(sizes[0]) * fh.used, false);
+
+            if(fh.used>0 && in!=1) {
+                throw("Table index exceeds file size.");
+            }
 
             onParsedTableInformation(ids, offsets, sizes, fh.used);
 
-            for(int i=0; i<fh.used; ++i) {
-                if(ids[i]==1) {
-                    startOffset = offsets[i];
-                    break;
+            unsigned long startOffset = findStartOffset(ids, offsets, fh.used);
+
+            for(unsigned int i=0; i<fh.used; ++i) {
+                if(!isKnownTable(ids[i])) {
+                    continue;
                 }
-            }
 
-            for(int i=0; i<fh.used; ++i) {
-                switch((int)ids[i]) {
-                    //Index Items; Offset start from startOffset
-                    case 0x04: read0x04(file, startOffset + offsets[i], sizes[i]);
-                        break; //Flags??
+                // One spare byte keeps trailing names terminated.  The buffer
+                // is only needed for this table's callback.
+                unsigned long pos = tablePosition(ids[i], offsets[i], startOffset);
 
-                    case 0x05: read0x05(file, startOffset + offsets[i], sizes[i]);
-                        break; //Time stamp??
+                if(pos>fileSize || sizes[i]>fileSize - pos) {
+                    throw("Table extends past the end of the file.");
+                }
+
+                double started = statsClock();
 
-                    case 0x06: read0x06(file, startOffset + offsets[i], sizes[i]);
-                        break; //Last saved time
+                if(bufferBudget!=0 && sizes[i]>bufferBudget &&
+                   (ids[i]==0x0a || ids[i]==0x07)) {
+                    readChunked(file, ids[i], pos, sizes[i]);
+                    statsTable(ids[i], sizes[i], started);
+                    continue;
+                }
 
-                    case 0x07: read0x07(file, startOffset + offsets[i], sizes[i]);
-                        break; //File mapping
+                size_t mark = arena->mark();
+                char *buffer = arena->allocate<char>(sizes[i] + 1);
+                fseek(file, pos, SEEK_SET);
+                in = fread(&buffer[0], sizes[i], 1, file);
+                statsRead(sizes[i], true);
+                buffer[sizes[i]] = '\0';
+                readTable(ids[i], buffer, sizes[i]);
+                arena->rewind(mark);
+                statsTable(ids[i], sizes[i], started);
+            }
 
-                    case 0x19: read0x19(file, startOffset + offsets[i], sizes[i]);
-                        break; //Creation time
+            if(dataTables) {
+                std::vector<std::pair<unsigned long, unsigned int> > order;
 
-                    case 0x1c: read0x1c(file, startOffset + offsets[i], sizes[i]);
-                        break; //DM information and version numbers
+                for(unsigned int i=0; i<fh.used; ++i) {
+                    if(isDataTable(ids[i])) {
+                        order.push_back(std::make_pair(tablePosition(ids[i], offsets[i],
+                                                       startOffset), i));
+                    }
+                }
 
-                    case 0x1d: read0x1d(file, startOffset + offsets[i], sizes[i]);
-                        break; //Software build information
+                std::sort(order.begin(), order.end());
+                dataBatch batch(*this);
 
-                    case 0x28: read0x28(file, startOffset + offsets[i], sizes[i]);
-                        break; //End of database marker??
+                for(size_t t=0; t<order.size(); ++t) {
+                    unsigned long pos = order[t].first;
+                    unsigned int i = order[t].second;
 
-                    //Non-Index Items; Offset start from 0
-                    case 0x0a: read0x0a(file, offsets[i], sizes[i]);
-                        break; //String table
+                    if(pos>fileSize || sizes[i]>fileSize - pos) {
+                        throw("Table extends past the end of the file.");
+                    }
 
-                    default:
-                        break;
+                    char *buffer = batch.reserve(sizes[i]);
+                    fseek(file, pos, SEEK_SET);
+                    in = fread(&buffer[0], sizes[i], 1, file);
+                    statsRead(sizes[i], true);
+                    batch.add(ids[i], sizes[i], buffer);
                 }
+
+                batch.flush();
             }
 
             fclose(file);
         } catch(...) {
+            if(file!=NULL) {
+                fclose(file);
+            }
+
+            scope.failed();
             onParsedError("Error: paring file.");
             return 1;
         }
 
         return 0;
     }
+
+    void oaFileParser::readAt(FILE *file, unsigned long pos, void *buffer,
+                              unsigned long len)
+    {
+        if(fseek(file, pos, SEEK_SET)!=0 || fread(buffer, 1, len, file)!=len) {
+            throw("Table extends past the end of the file.");
+        }
+
+        statsRead(len, true);
+    }
+
+    void oaFileParser::readChunked(FILE *file, unsigned long id,
+                                   unsigned long pos, unsigned long tblSize)
+    {
+        size_t mark = arena->mark();
+
+        if(id==0x0a) {
+            readStringTableChunked(file, pos, tblSize);
+        } else {
+            readDatabaseMapChunked(file, pos, tblSize);
+        }
+
+        arena->rewind(mark);
+    }
+
+    void oaFileParser::readStringTableChunked(FILE *file, unsigned long pos,
+                                              unsigned long tblSize)
+    {
+        tableIndex table;
+        unsigned int empty;
+
+        if(tblSize<sizeof(table) + sizeof(empty)) {
+            throw("String table is too small.");
+        }
+
+        readAt(file, pos, &table, sizeof(table));
+        onParsedStringTableBegin(table);
+
+        // A chunk ends after the last NUL that fits; the unfinished string
+        // behind it is moved to the front of the next chunk.
+        unsigned long start = pos + sizeof(table) + sizeof(empty);
+        unsigned long size = std::min<unsigned long>(table.used,
+                             tblSize - sizeof(table) - sizeof(empty));
+        char *buffer = arena->allocate<char>(bufferBudget + 1);
+        unsigned long done = 0;
+        unsigned long carry = 0;
+
+        while(done<size) {
+            unsigned long in = std::min(bufferBudget - carry, size - done - carry);
+            readAt(file, start + done + carry, buffer + carry, in);
+            unsigned long len = carry + in;
+
+            if(done + len<size) {
+                const char *last = (const char *)memrchr(buffer, '\0', len);
+
+                if(last==NULL) {
+                    throw("String exceeds the buffer budget.");
+                }
+
+                len = last + 1 - buffer;
+            } else {
+                // The spare byte keeps a trailing name terminated.
+                buffer[len] = '\0';
+            }
+
+            onParsedStringTableChunk(buffer, len, done);
+            carry = carry + in - len;
+            memmove(buffer, buffer + len, carry);
+            done += len;
+        }
+
+        onParsedStringTableEnd();
+    }
+
+    void oaFileParser::readDatabaseMapChunked(FILE *file, unsigned long pos,
+                                              unsigned long tblSize)
+    {
+        unsigned int count[2];
+        readAt(file, pos, count, sizeof(count));
+        unsigned long numRes = count[0];
+        unsigned long numData = count[1];
+        const unsigned long entrySize = sizeof(unsigned long) + sizeof(unsigned int);
+
+        if(numData<numRes || sizeof(count) + entrySize * numData > tblSize) {
+            throw("Database map exceeds its table size.");
+        }
+
+        onParsedDatabaseMapBegin(numRes, numData - numRes);
+
+        if(dbMap!=NULL) {
+            dbMap->startMap();
+        }
+
+        // Ids and types of a section are stored apart, so every chunk is
+        // read from both.
+        unsigned long perChunk = bufferBudget / entrySize;
+        unsigned long *ids = arena->allocate<unsigned long>(perChunk);
+        unsigned int *types = arena->allocate<unsigned int>(perChunk);
+        unsigned long section = pos + sizeof(count);
+        unsigned long sectionSize[2] = {numRes, numData - numRes};
+
+        for(int s=0; s<2; ++s) {
+            unsigned long num = sectionSize[s];
+
+            for(unsigned long first=0; first<num; first+=perChunk) {
+                unsigned long n = std::min(perChunk, num - first);
+                readAt(file, section + sizeof(ids[0]) * first, ids, sizeof(ids[0]) * n);
+                readAt(file, section + sizeof(ids[0]) * num + sizeof(types[0]) * first,
+                       types, sizeof(types[0]) * n);
+
+                if(dbMap!=NULL) {
+                    dbMap->appendMap(ids, types, n, s==1);
+                }
+
+                onParsedDatabaseMapChunk(ids, types, n, s==1);
+            }
+
+            section += entrySize * num;
+        }
+
+        if(dbMap!=NULL) {
+            dbMap->finishMap();
+        }
+
+        onParsedDatabaseMapEnd();
+    }
+
+    void oaFileParser::readFully(oaReader &reader, void *buffer,
+                                 unsigned long len)
+    {
+        char *b = (char *)buffer;
+
+        while(len>0) {
+            long in = reader.read(b, len);
+
+            if(in<=0) {
+                throw("Unexpected end of input.");
+            }
+
+            statsRead(in, false);
+            b += in;
+            len -= in;
+        }
+    }
+
+    int oaFileParser::parseStream(oaReader &reader)
+    {
+        statsScope scope(stats, NULL);
+
+        try {
+            fileHeader fh;
+            readFully(reader, &fh, sizeof(fh));
+            onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size, fh.used);
+
+            arena->reset();
+
+            if(dbMap!=NULL) {
+                dbMap->clear();
+            }
+
+            // A stream has no size to check fh.used against, so the index
+            // grows in chunks and a bogus count runs out of input before it
+            // runs out of memory.
+            const size_t indexChunk = 4096;
+            size_t indexSize = (size_t)fh.used * 3;
+            std::vector<unsigned long> index;
+
+            while(index.size()<indexSize) {
+                size_t have = index.size();
+                index.resize(have + std::min(indexChunk, indexSize - have));
+                readFully(reader, &index[have], sizeof(index[0]) * (index.size() - have));
+            }
+
+            unsigned long *ids = index.data();
+            unsigned long *offsets = ids + fh.used;
+            unsigned long *sizes = offsets + fh.used;
+            onParsedTableInformation(ids, offsets, sizes, fh.used);
+
+            unsigned long startOffset = findStartOffset(ids, offsets, fh.used);
+            std::vector<std::pair<unsigned long, unsigned int> > order;
+
+            for(unsigned int i=0; i<fh.used; ++i) {
+                if(isKnownTable(ids[i]) || (dataTables && isDataTable(ids[i]))) {
+                    order.push_back(std::make_pair(tablePosition(ids[i], offsets[i],
+                                                   startOffset), i));
+                }
+            }
+
+            std::sort(order.begin(), order.end());
+            unsigned long pos = sizeof(fh) + sizeof(unsigned long) * 3 * fh.used;
+            const unsigned long skipSize = 64 * 1024;
+            char *skip = arena->allocate<char>(skipSize);
+            dataBatch batch(*this);
+
+            for(size_t t=0; t<order.size(); ++t) {
+                unsigned int i = order[t].second;
+
+                if(order[t].first<pos) {
+                    throw("Table overlaps the data before it.");
+                }
+
+                // Rejected before the spare byte or the end position wraps.
+                if(sizes[i]>=(unsigned long)-1 - order[t].first) {
+                    throw("Table size is out of range.");
+                }
+
+                while(pos<order[t].first) {
+                    unsigned long len = std::min(skipSize, order[t].first - pos);
+                    readFully(reader, skip, len);
+                    pos += len;
+                }
+
+                if(!isKnownTable(ids[i])) {
+                    char *buffer = batch.reserve(sizes[i]);
+                    readFully(reader, buffer, sizes[i]);
+                    pos += sizes[i];
+                    batch.add(ids[i], sizes[i], buffer);
+                    continue;
+                }
+
+                // One spare byte keeps trailing names terminated.
+                double started = statsClock();
+                size_t mark = arena->mark();
+                char *buffer = arena->allocate<char>(sizes[i] + 1);
+                readFully(reader, buffer, sizes[i]);
+                buffer[sizes[i]] = '\0';
+                pos += sizes[i];
+                readTable(ids[i], buffer, sizes[i]);
+                arena->rewind(mark);
+                statsTable(ids[i], sizes[i], started);
+            }
+
+            batch.flush();
+        } catch(...) {
+            scope.failed();
+            onParsedError("Error: paring file.");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int oaFileParser::parseStream(int fd)
+    {
+        oaFdReader reader(fd);
+        return parseStream(reader);
+    }
+
+    int oaFileParser::parseCached(const char *filePath, oaParseCache &cache)
+    {
+        statsScope scope(stats, filePath);
+
+        if(dbMap!=NULL) {
+            dbMap->clear();
+        }
+
+        int status = cache.parse(*this, filePath);
+
+        if(status!=0) {
+            scope.failed();
+        }
+
+        return status;
+    }
+
+    int oaFileParser::readDirectory(const char *filePath, tableDirectory &dir)
+    {
+        if(dir.open(filePath)!=0) {
+            onParsedError("Error: paring file.");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int oaFileParser::parseTable(const tableDirectory &dir, unsigned long id)
+    {
+        int i = dir.find(id);
+
+        if(i<0 || !isKnownTable(id)) {
+            return 1;
+        }
+
+        statsScope scope(stats, NULL);
+
+        try {
+            // One spare byte keeps trailing names terminated.
+            double started = statsClock();
+            unsigned long tblSize = dir.sizes[i];
+            unsigned long pos = dir.position(i);
+
+            // Checked before the buffer is allocated for it.
+            if(pos>dir.fileSize || tblSize>dir.fileSize - pos) {
+                throw("Table extends past the end of the file.");
+            }
+
+            arena->reset();
+            char *buffer = arena->allocate<char>(tblSize + 1);
+
+            if(dir.read(i, buffer)!=0) {
+                throw("Table extends past the end of the file.");
+            }
+
+            statsRead(tblSize, true);
+            buffer[tblSize] = '\0';
+            readTable(id, buffer, tblSize);
+            statsTable(id, tblSize, started);
+        } catch(...) {
+            scope.failed();
+            onParsedError("Error: paring file.");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int oaFileParser::parseMapped(const char *filePath)
+    {
+        statsScope scope(stats, filePath);
+
+        try {
+            releaseMapping();
+            arena->reset();
+
+            if(dbMap!=NULL) {
+                dbMap->clear();
+            }
+
+            int fd = open(filePath, O_RDONLY);
+
+            if(fd<0) {
+                throw("File path does not exist.");
+            }
+
+            struct stat st;
+
+            if(fstat(fd, &st)!=0 || (unsigned long)st.st_size<sizeof(fileHeader)) {
+                close(fd);
+                throw("File is too small.");
+            }
+
+            void *addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                              fd, 0);
+            close(fd);
+
+            if(addr==MAP_FAILED) {
+                throw("Unable to map file.");
+            }
+
+            mapData = (char *)addr;
+            mapSize = st.st_size;
+
+            fileHeader fh;
+            memcpy(&fh, mapData, sizeof(fh));
+            onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size, fh.used);
+
+            if(fh.used > (mapSize - sizeof(fh)) / (sizeof(unsigned long) * 3)) {
+                throw("Table index exceeds file size.");
+            }
+
+            // The index directly follows the 8 byte aligned header.
+            unsigned long *ids = (unsigned long *)(mapData + sizeof(fh));
+            unsigned long *offsets = ids + fh.used;
+            unsigned long *sizes = offsets + fh.used;
+
+            onParsedTableInformation(ids, offsets, sizes, fh.used);
+
+            unsigned long startOffset = findStartOffset(ids, offsets, fh.used);
+
+            for(unsigned int i=0; i<fh.used; ++i) {
+                if(!isKnownTable(ids[i])) {
+                    continue;
+                }
+
+                unsigned long pos = tablePosition(ids[i], offsets[i], startOffset);
+
+                if(pos>mapSize || sizes[i]>mapSize - pos) {
+                    throw("Table extends past the end of the file.");
+                }
+
+                double started = statsClock();
+                statsRead(sizes[i], false);
+                readTable(ids[i], mapData + pos, sizes[i]);
+                statsTable(ids[i], sizes[i], started);
+            }
+
+            if(dataTables) {
+                std::vector<std::pair<unsigned long, unsigned int> > order;
+
+                for(unsigned int i=0; i<fh.used; ++i) {
+                    if(isDataTable(ids[i])) {
+                        order.push_back(std::make_pair(tablePosition(ids[i], offsets[i],
+                                                       startOffset), i));
+                    }
+                }
+
+                // The batch points straight into the mapping.
+                std::sort(order.begin(), order.end());
+                dataBatch batch(*this);
+
+                for(size_t t=0; t<order.size(); ++t) {
+                    unsigned long pos = order[t].first;
+                    unsigned int i = order[t].second;
+
+                    if(pos>mapSize || sizes[i]>mapSize - pos) {
+                        throw("Table extends past the end of the file.");
+                    }
+
+                    statsRead(sizes[i], false);
+                    batch.room(sizes[i]);
+                    batch.add(ids[i], sizes[i], mapData + pos);
+                }
+
+                batch.flush();
+            }
+        } catch(...) {
+            scope.failed();
+            onParsedError("Error: paring file.");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // Reads the tables of a directory, in the given order, on a pool of
+    // threads.  At most window tables are read ahead of the one the
+    // consumer waits for, which bounds the memory held.  Buffers carry one
+    // spare terminating byte and stay valid until release().
+    class oaFileParser::tableReader
+    {
+    public:
+        tableReader(const tableDirectory &dir, const std::vector<unsigned int> &order,
+                    unsigned int numThreads)
+            : dir(dir), order(order), buffers(order.size()), state(order.size(), 0),
+              next(0), consumed(0), window(numThreads * 2), stopping(false) {
+            for(unsigned int i=0; i<numThreads; ++i) {
+                threads.push_back(std::thread([this]() {
+                    work();
+                }));
+            }
+        };
+        ~tableReader() {
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                stopping = true;
+            }
+
+            changed.notify_all();
+
+            for(size_t i=0; i<threads.size(); ++i) {
+                threads[i].join();
+            }
+        };
+
+        // Waits for task t and returns its buffer, or NULL if it could not
+        // be read.
+        char *get(size_t t) {
+            std::unique_lock<std::mutex> guard(lock);
+            consumed = t;
+            changed.notify_all();
+            changed.wait(guard, [this, t]() {
+                return state[t]!=readPending;
+            });
+            return state[t]==readDone ? buffers[t].data() : NULL;
+        };
+        void release(size_t t) {
+            std::vector<char>().swap(buffers[t]);
+        };
+
+    private:
+        enum readState {
+            readPending,
+            readDone,
+            readFailed
+        };
+
+        void work() {
+            while(true) {
+                size_t t;
+
+                {
+                    std::unique_lock<std::mutex> guard(lock);
+                    changed.wait(guard, [this]() {
+                        return stopping || next>=order.size() || next<consumed + window;
+                    });
+
+                    if(stopping || next>=order.size()) {
+                        return;
+                    }
+
+                    t = next++;
+                }
+
+                // A corrupt size must not reach the allocation; anything
+                // thrown here would end the process.
+                unsigned int i = order[t];
+                unsigned long pos = dir.position(i);
+                bool ok = pos<=dir.fileSize && dir.sizes[i]<=dir.fileSize - pos;
+
+                try {
+                    if(ok) {
+                        buffers[t].resize(dir.sizes[i] + 1);
+                        ok = dir.read(i, buffers[t].data())==0;
+                    }
+                } catch(...) {
+                    ok = false;
+                }
+
+                if(ok) {
+                    buffers[t][dir.sizes[i]] = '\0';
+                } else {
+                    std::vector<char>().swap(buffers[t]);
+                }
+
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    state[t] = ok ? readDone : readFailed;
+                }
+
+                changed.notify_all();
+            }
+        };
+
+        const tableDirectory                &dir;
+        const std::vector<unsigned int>     &order;
+        std::vector<std::vector<char> >     buffers;
+        std::vector<char>                   state;
+        size_t                              next;
+        size_t                              consumed;
+        size_t                              window;
+        bool                                stopping;
+        std::mutex                          lock;
+        std::condition_variable             changed;
+        std::vector<std::thread>            threads;
+    };
+
+    int oaFileParser::parseParallel(const char *filePath,
+                                    unsigned int numThreads)
+    {
+        statsScope scope(stats, filePath);
+
+        try {
+            tableDirectory dir;
+
+            if(dir.open(filePath)!=0) {
+                throw("File path does not exist.");
+            }
+
+            fileHeader &fh = dir.header;
+            onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size, fh.used);
+            arena->reset();
+
+            if(dbMap!=NULL) {
+                dbMap->clear();
+            }
+
+            onParsedTableInformation(dir.ids, dir.offsets, dir.sizes, fh.used);
+
+            // Decoded tables in index order, then the data tables in file
+            // order, as parse() delivers them.
+            std::vector<unsigned int> order;
+            std::vector<std::pair<unsigned long, unsigned int> > data;
+
+            for(unsigned int i=0; i<fh.used; ++i) {
+                if(isKnownTable(dir.ids[i])) {
+                    order.push_back(i);
+                } else if(dataTables && isDataTable(dir.ids[i])) {
+                    data.push_back(std::make_pair(dir.position(i), i));
+                }
+            }
+
+            size_t numKnown = order.size();
+            std::sort(data.begin(), data.end());
+
+            for(size_t t=0; t<data.size(); ++t) {
+                order.push_back(data[t].second);
+            }
+
+            if(numThreads==0) {
+                numThreads = std::thread::hardware_concurrency();
+            }
+
+            tableReader reader(dir, order, std::max(numThreads, 1u));
+            dataBatch batch(*this);
+            std::vector<size_t> held;
+
+            for(size_t t=0; t<order.size(); ++t) {
+                unsigned int i = order[t];
+                double started = statsClock();
+                char *buffer = reader.get(t);
+
+                if(buffer==NULL) {
+                    throw("Table extends past the end of the file.");
+                }
+
+                statsRead(dir.sizes[i], true);
+
+                if(t<numKnown) {
+                    size_t mark = arena->mark();
+                    readTable(dir.ids[i], buffer, dir.sizes[i]);
+                    arena->rewind(mark);
+                    reader.release(t);
+                    statsTable(dir.ids[i], dir.sizes[i], started);
+                    continue;
+                }
+
+                // Data table buffers are kept until their batch is out.
+                batch.room(dir.sizes[i]);
+
+                if(batch.empty()) {
+                    for(size_t h=0; h<held.size(); ++h) {
+                        reader.release(held[h]);
+                    }
+
+                    held.clear();
+                }
+
+                batch.add(dir.ids[i], dir.sizes[i], buffer);
+                held.push_back(t);
+            }
+
+            batch.flush();
+        } catch(...) {
+            scope.failed();
+            onParsedError("Error: paring file.");
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // One file of parseFiles().  Reads are tagged with the file's position
+    // in the list and a slot: 0 for the header, 1 for the index and 2 + i
+    // for table i.  failure records how far the callbacks get before the
+    // error, as with parse().
+    struct oaFileParser::asyncFile {
+        enum failure {
+            noFailure,
+            failedHeader,
+            failedIndex,
+            failedTables
+        };
+
+        asyncFile()
+            : path(NULL), fd(-1), fileSize(0), bytes(0), pending(0),
+              failed(noFailure) {
+            memset(&header, 0, sizeof(header));
+        };
+        ~asyncFile() {
+            if(fd>=0) {
+                ::close(fd);
+            }
+        };
+
+        const char                     *path;
+        int                             fd;
+        unsigned long                   fileSize;
+        fileHeader                      header;
+        std::vector<unsigned long>      index;
+        std::vector<unsigned long>      positions;
+        std::vector<unsigned long>      at;     // Offset of each table in data.
+        std::vector<char>               tableOk;
+        std::unique_ptr<char[]>         data;
+        unsigned long                   bytes;  // Size of data.
+        unsigned int                    pending;
+        failure                         failed;
+    };
+
+    static unsigned long asyncTag(size_t index, unsigned long slot)
+    {
+        return ((unsigned long)index << 32) | slot;
+    }
+
+    void oaFileParser::startFile(asyncFile &file, const char *filePath,
+                                 size_t index, oaAsyncIO &io)
+    {
+        struct stat st;
+        file.path = filePath;
+        file.fd = ::open(filePath, O_RDONLY);
+
+        if(file.fd<0 || fstat(file.fd, &st)!=0) {
+            file.failed = asyncFile::failedHeader;
+            return;
+        }
+
+        file.fileSize = st.st_size;
+        io.read(file.fd, 0, (char *)&file.header, sizeof(file.header),
+                asyncTag(index, 0));
+        ++file.pending;
+    }
+
+    void oaFileParser::readFile(asyncFile &file, const asyncRead &read,
+                                oaAsyncIO &io)
+    {
+        size_t index = read.tag >> 32;
+        unsigned long slot = read.tag & 0xffffffff;
+        unsigned long used = file.header.used;
+        --file.pending;
+
+        if(slot==0) {
+            if(read.result!=sizeof(file.header)) {
+                file.failed = asyncFile::failedHeader;
+            } else if(used > (file.fileSize - sizeof(file.header)) /
+                      (sizeof(unsigned long) * 3)) {
+                file.failed = asyncFile::failedIndex;
+            } else if(used>0) {
+                try {
+                    file.index.resize(used * 3);
+                } catch(...) {
+                    file.failed = asyncFile::failedIndex;
+                    return;
+                }
+
+                io.read(file.fd, sizeof(file.header), (char *)file.index.data(),
+                        sizeof(unsigned long) * used * 3, asyncTag(index, 1));
+                ++file.pending;
+            }
+
+            return;
+        }
+
+        if(slot>1) {
+            unsigned int i = slot - 2;
+            file.tableOk[i] = read.result==(long)file.index[used * 2 + i];
+            return;
+        }
+
+        if(read.result!=(long)(sizeof(unsigned long) * used * 3)) {
+            file.failed = asyncFile::failedIndex;
+            return;
+        }
+
+        // Every table parse() would read goes out at once, into one buffer
+        // with a spare terminating byte after each table.  Tables that do
+        // not overlap fit in the file size plus the spare bytes, so a larger
+        // total means a corrupt index and fails the file instead.
+        unsigned long *ids = file.index.data();
+        unsigned long *offsets = ids + used;
+        unsigned long *sizes = offsets + used;
+        unsigned long startOffset = findStartOffset(ids, offsets, used);
+        unsigned long limit = file.fileSize + used;
+
+        try {
+            file.positions.assign(used, 0);
+            file.at.assign(used, 0);
+            file.tableOk.assign(used, 0);
+
+            for(unsigned int i=0; i<used; ++i) {
+                if(!isKnownTable(ids[i]) && !(dataTables && isDataTable(ids[i]))) {
+                    continue;
+                }
+
+                unsigned long pos = tablePosition(ids[i], offsets[i], startOffset);
+                file.positions[i] = pos;
+
+                if(pos>file.fileSize || sizes[i]>file.fileSize - pos) {
+                    continue;
+                }
+
+                if(sizes[i]>=limit - file.bytes) {
+                    throw("Tables exceed the file size.");
+                }
+
+                file.at[i] = file.bytes;
+                file.bytes += sizes[i] + 1;
+                file.tableOk[i] = 1;
+            }
+
+            file.data.reset(new char[file.bytes]);
+        } catch(...) {
+            file.failed = asyncFile::failedTables;
+            file.bytes = 0;
+            return;
+        }
+
+        for(unsigned int i=0; i<used; ++i) {
+            if(file.tableOk[i]==0) {
+                continue;
+            }
+
+            char *buffer = file.data.get() + file.at[i];
+            buffer[sizes[i]] = '\0';
+            file.tableOk[i] = 0;
+            io.read(file.fd, file.positions[i], buffer, sizes[i], asyncTag(index, 2 + i));
+            ++file.pending;
+        }
+    }
+
+    int oaFileParser::deliverFile(asyncFile &file)
+    {
+        int status = 0;
+        onParsedFileBegin(file.path);
+
+        {
+            statsScope scope(stats, file.path);
+
+            try {
+                if(file.failed==asyncFile::failedHeader) {
+                    throw("File is too small.");
+                }
+
+                fileHeader &fh = file.header;
+                statsRead(sizeof(fh), false);
+                onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size, fh.used);
+                arena->reset();
+
+                if(dbMap!=NULL) {
+                    dbMap->clear();
+                }
+
+                if(file.failed==asyncFile::failedIndex) {
+                    throw("Table index exceeds file size.");
+                }
+
+                unsigned long *ids = file.index.data();
+                unsigned long *offsets = ids + fh.used;
+                unsigned long *sizes = offsets + fh.used;
+                statsRead(sizeof(unsigned long) * fh.used * 3, false);
+                onParsedTableInformation(ids, offsets, sizes, fh.used);
+
+                if(file.failed==asyncFile::failedTables) {
+                    throw("Tables exceed the file size.");
+                }
+
+                for(unsigned int i=0; i<fh.used; ++i) {
+                    if(!isKnownTable(ids[i])) {
+                        continue;
+                    }
+
+                    if(!file.tableOk[i]) {
+                        throw("Table extends past the end of the file.");
+                    }
+
+                    double started = statsClock();
+                    statsRead(sizes[i], true);
+                    size_t mark = arena->mark();
+                    readTable(ids[i], file.data.get() + file.at[i], sizes[i]);
+                    arena->rewind(mark);
+                    statsTable(ids[i], sizes[i], started);
+                }
+
+                if(dataTables) {
+                    std::vector<std::pair<unsigned long, unsigned int> > order;
+
+                    for(unsigned int i=0; i<fh.used; ++i) {
+                        if(isDataTable(ids[i])) {
+                            order.push_back(std::make_pair(file.positions[i], i));
+                        }
+                    }
+
+                    std::sort(order.begin(), order.end());
+                    dataBatch batch(*this);
+
+                    for(size_t t=0; t<order.size(); ++t) {
+                        unsigned int i = order[t].second;
+
+                        if(!file.tableOk[i]) {
+                            throw("Table extends past the end of the file.");
+                        }
+
+                        statsRead(sizes[i], true);
+                        batch.room(sizes[i]);
+                        batch.add(ids[i], sizes[i], file.data.get() + file.at[i]);
+                    }
+
+                    batch.flush();
+                }
+            } catch(...) {
+                scope.failed();
+                onParsedError("Error: paring file.");
+                status = 1;
+            }
+        }
+
+        onParsedFileEnd(file.path, status);
+        return status;
+    }
+
+    int oaFileParser::parseFiles(const std::vector<std::string> &filePaths,
+                                 unsigned int queueDepth)
+    {
+        queueDepth = std::max(queueDepth, 1u);
+        // Declared before io, so the buffers outlive any read still in flight.
+        std::deque<asyncFile> files;
+        oaAsyncIO io(queueDepth);
+        std::vector<asyncRead> done;
+        size_t first = 0;
+        size_t next = 0;
+        unsigned long held = 0;
+        int failed = 0;
+
+        try {
+            while(first<filePaths.size()) {
+                while(next<filePaths.size() && files.size()<queueDepth &&
+                      (files.empty() || held<asyncWindowBytes)) {
+                    files.emplace_back();
+                    startFile(files.back(), filePaths[next].c_str(), next, io);
+                    ++next;
+                }
+
+                // Files are delivered in order as soon as all their reads are in.
+                if(files.front().pending==0) {
+                    failed += deliverFile(files.front());
+                    held -= files.front().bytes;
+                    files.pop_front();
+                    ++first;
+                    continue;
+                }
+
+                done.clear();
+                io.complete(done);
+
+                for(size_t d=0; d<done.size(); ++d) {
+                    asyncFile &file = files[(done[d].tag >> 32) - first];
+                    unsigned long bytes = file.bytes;
+                    readFile(file, done[d], io);
+                    held += file.bytes - bytes;
+                }
+            }
+        } catch(...) {
+            // Collect the reads in flight before their buffers are freed.
+            while(io.outstanding()>0 && io.complete(done)>0) {
+                done.clear();
+            }
+
+            throw;
+        }
+
+        return failed;
+    }
 } //End namespace oafp
@@ -0,0 +1,319 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaFileParserC.h"
+#include "oaDatabaseMap.h"
+#include "oaFileParser.h"
+#include "oaLibraryScanner.h"
+#include "oaStringTable.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The records are read in place from other languages, so the layout must
+// not depend on the compiler inserting padding.
+static_assert(offsetof(oafpFile, buildNameOffset)==136, "oafpFile has implicit padding.");
+static_assert(sizeof(oafpFile)==168, "oafpFile has implicit padding.");
+static_assert(sizeof(oafpResult)==40, "oafpResult has implicit padding.");
+
+namespace oafp
+{
+    // Decodes one file into an oafpFile followed by its payload.  Offsets
+    // in the record are relative to the start of the record and are moved
+    // to their place in the result block by resultScanner.
+    class resultParser : public oaFileParser
+    {
+    public:
+        resultParser() {
+            memset(&record, 0, sizeof(record));
+            setIndexStrings(true);
+            setDatabaseMap(&map);
+        };
+
+        // Returns the record and its payload as one string.
+        void finish(const std::string &path, int status, std::string &out) {
+            record.status = status;
+            record.pathOffset = appendString(path.c_str());
+
+            if(map.count()>0) {
+                record.mapCount = map.count();
+                record.mapOffset = reserve(sizeof(oafpMapEntry) * map.count());
+                oafpMapEntry *entries = (oafpMapEntry *)&payload[record.mapOffset -
+                                         sizeof(record)];
+
+                for(unsigned int i=0; i<map.count(); ++i) {
+                    entries[i].id = map.ids()[i];
+                    entries[i].type = map.types()[i];
+                    entries[i].dataTable = map.isDataTable(i) ? 1 : 0;
+                }
+            }
+
+            // Built aside, so out is either whole or left empty on a throw.
+            std::string block;
+            block.reserve(sizeof(record) + payload.size());
+            block.assign((const char *)&record, sizeof(record));
+            block.append(payload);
+            out.swap(block);
+        };
+
+    protected:
+        virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                     unsigned short schema, unsigned long offset,
+                                     unsigned int size, unsigned int used) {
+            record.testBit = testBit;
+            record.type = type;
+            record.schema = schema;
+            record.offset = offset;
+            record.size = size;
+            record.used = used;
+        };
+        virtual void onParsedTableInformation(unsigned long ids[],
+                                              unsigned long offsets[],
+                                              unsigned long sizes[], unsigned int num) {
+            record.tableCount = num;
+            record.tablesOffset = reserve(sizeof(oafpTable) * num);
+            oafpTable *tables = (oafpTable *)&payload[record.tablesOffset -
+                                sizeof(record)];
+
+            for(unsigned int i=0; i<num; ++i) {
+                tables[i].id = ids[i];
+                tables[i].offset = offsets[i];
+                tables[i].size = sizes[i];
+            }
+        };
+        virtual void onParsedFlags(unsigned int flags) {
+            record.present |= OAFP_HAS_FLAGS;
+            record.flags = flags;
+        };
+        virtual void onParsedTimeStamp(unsigned int timeStamp) {
+            record.present |= OAFP_HAS_TIMESTAMP;
+            record.timeStamp = timeStamp;
+        };
+        virtual void onParsedLastSavedTime(unsigned long lastSavedTime) {
+            record.present |= OAFP_HAS_LAST_SAVED;
+            record.lastSavedTime = lastSavedTime;
+        };
+        virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                         unsigned int idCount, unsigned long tblIds[],
+                                         unsigned int tblTypes[], unsigned int tblCount) {
+            record.present |= OAFP_HAS_MAP;
+        };
+        virtual void onParsedStringTable(tableIndex table, const char *buffer) {
+        };
+        virtual void onParsedStringTableIndex(const oaStringTable &strings) {
+            record.present |= OAFP_HAS_STRINGS;
+            record.stringCount = strings.count();
+            record.stringsSize = strings.table().used;
+            record.stringsDeleted = strings.table().deleted;
+            record.stringsFirst = strings.table().first;
+            record.stringsOffset = reserve(record.stringsSize + 1);
+            memcpy(&payload[record.stringsOffset - sizeof(record)], strings.data(),
+                   record.stringsSize);
+        };
+        virtual void onParsedCreateTime(unsigned long createTime) {
+            unsigned int downTime[2];
+
+            // Something going on with time in versions of >=22.43
+            memcpy(&downTime, &createTime, sizeof(downTime));
+            record.present |= OAFP_HAS_CREATE_TIME;
+            record.createTime = downTime[0]!=0 ? downTime[0] : downTime[1];
+        };
+        virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                            const char *buildName) {
+            record.present |= OAFP_HAS_DM_BUILD;
+            record.dataModelRev = dataModelRev;
+            record.buildNameOffset = appendString(buildName);
+        };
+        virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                              unsigned short kitDataModelRev,
+                                              unsigned short appAPIMinorRev,
+                                              unsigned short kitReleaseNum,
+                                              const char *appBuildName,
+                                              const char *kitBuildName,
+                                              const char *platforName) {
+            record.present |= OAFP_HAS_BUILD_INFO;
+            record.appDataModelRev = appDataModelRev;
+            record.kitDataModelRev = kitDataModelRev;
+            record.appAPIMinorRev = appAPIMinorRev;
+            record.kitReleaseNum = kitReleaseNum;
+            record.appBuildNameOffset = appendString(appBuildName);
+            record.kitBuildNameOffset = appendString(kitBuildName);
+            record.platformNameOffset = appendString(platforName);
+        };
+        virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                          unsigned long num) {
+            record.present |= OAFP_HAS_MAP_DELTA;
+        };
+        virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
+            record.present |= OAFP_HAS_MARKER;
+            record.marker = bitCheck;
+        };
+        virtual void onParsedError(const char *error) {
+            record.errorOffset = appendString(error);
+        };
+
+    private:
+        // Adds size zeroed bytes, 8 byte aligned, and returns their offset.
+        uint64_t reserve(size_t size) {
+            uint64_t offset = sizeof(record) + payload.size();
+            payload.append((size + 7) & ~(size_t)7, '\0');
+            return offset;
+        };
+        uint64_t appendString(const char *text) {
+            size_t len = strlen(text);
+            uint64_t offset = reserve(len + 1);
+            memcpy(&payload[offset - sizeof(record)], text, len);
+            return offset;
+        };
+
+        oafpFile            record;
+        std::string         payload;
+        oaDatabaseMap       map;
+    };
+
+    // Parses the files on the scanner's pool and gathers the records in
+    // path order, with the payloads in a separate run behind them.
+    class resultScanner : public oaLibraryScanner
+    {
+    public:
+        resultScanner(unsigned int numThreads)
+            : oaLibraryScanner(numThreads), failed(0) {
+        };
+
+        oafpResult *build() {
+            size_t filesOffset = (sizeof(oafpResult) + 7) & ~(size_t)7;
+            size_t payloadOffset = filesOffset + sizeof(oafpFile) * records.size();
+            size_t size = payloadOffset + payload.size();
+            char *block = (char *)malloc(size);
+
+            if(block==NULL) {
+                return NULL;
+            }
+
+            oafpResult *result = (oafpResult *)block;
+            memset(block, 0, filesOffset);
+            memcpy(result->magic, "OAFPRSLT", sizeof(result->magic));
+            result->version = OAFP_RESULT_VERSION;
+            result->fileCount = records.size();
+            result->size = size;
+            result->filesOffset = filesOffset;
+            result->recordSize = sizeof(oafpFile);
+            result->failed = failed;
+
+            for(size_t i=0; i<records.size(); ++i) {
+                oafpFile &r = records[i];
+                uint64_t *offsets[] = {&r.pathOffset, &r.errorOffset, &r.tablesOffset,
+                                       &r.mapOffset, &r.stringsOffset, &r.buildNameOffset,
+                                       &r.appBuildNameOffset, &r.kitBuildNameOffset,
+                                       &r.platformNameOffset
+                                      };
+
+                for(size_t o=0; o<sizeof(offsets) / sizeof(offsets[0]); ++o) {
+                    if(*offsets[o]!=0) {
+                        *offsets[o] += payloadOffset + bases[i] - sizeof(oafpFile);
+                    }
+                }
+            }
+
+            memcpy(block + filesOffset, records.data(), sizeof(oafpFile) * records.size());
+            memcpy(block + payloadOffset, payload.data(), payload.size());
+            return result;
+        };
+
+    protected:
+        virtual int onScanFile(unsigned int worker, const std::string &path,
+                               std::string &result, std::string &error) {
+            resultParser parser;
+            int status = parser.parse(path.c_str());
+            parser.finish(path, status, result);
+            return status;
+        };
+        virtual void onScanResult(const std::string &path, int status,
+                                  const std::string &result, const std::string &error) {
+            oafpFile record;
+
+            // The scanner hands over an empty result if onScanFile() threw.
+            if(result.size()<sizeof(record)) {
+                memset(&record, 0, sizeof(record));
+                record.status = status!=0 ? status : 1;
+                records.push_back(record);
+                bases.push_back(payload.size());
+                ++failed;
+                return;
+            }
+
+            memcpy(&record, result.data(), sizeof(record));
+            records.push_back(record);
+            bases.push_back(payload.size());
+            payload.append(result, sizeof(record), std::string::npos);
+
+            if(status!=0) {
+                ++failed;
+            }
+        };
+
+    private:
+        std::vector<oafpFile>       records;
+        std::vector<size_t>         bases;
+        std::string                 payload;
+        unsigned int                failed;
+    };
+
+} //End namespace oafp
+
+extern "C" int oafpParseFiles(const char *const *paths, unsigned int count,
+                              unsigned int numThreads, oafpResult **result)
+{
+    if(result==NULL) {
+        return -1;
+    }
+
+    *result = NULL;
+
+    if(paths==NULL && count!=0) {
+        return -1;
+    }
+
+    try {
+        std::vector<std::string> files(paths, paths + count);
+        oafp::resultScanner scanner(numThreads);
+
+        if(scanner.scan(files)<0) {
+            return -1;
+        }
+
+        *result = scanner.build();
+        return *result!=NULL ? (*result)->failed : -1;
+    } catch(...) {
+        return -1;
+    }
+}
+
+extern "C" void oafpFreeResult(oafpResult *result)
+{
+    free(result);
+}
@@ -0,0 +1,156 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAFILEPARSERC_H_
+#define OAFILEPARSERC_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * C interface for parsing a batch of files in one call.  oafpParseFiles()
+ * returns everything it decoded in a single malloc'ed block that starts
+ * with an oafpResult.  Everything else in the block is addressed by byte
+ * offsets from the start of the block, so it can be read in place from
+ * any language and never needs fixing up; an offset of 0 means absent.
+ * Arrays are 8 byte aligned and strings NUL terminated.
+ *
+ * The layout only ever grows at the end of the structs.  Readers check
+ * version and use recordSize to step through the file records.
+ */
+
+#define OAFP_RESULT_VERSION     1
+
+/* Bits of oafpFile.present, one per metadata table seen. */
+#define OAFP_HAS_FLAGS          0x0001  /* 0x04 */
+#define OAFP_HAS_TIMESTAMP      0x0002  /* 0x05 */
+#define OAFP_HAS_LAST_SAVED     0x0004  /* 0x06 */
+#define OAFP_HAS_MAP            0x0008  /* 0x07 */
+#define OAFP_HAS_STRINGS        0x0010  /* 0x0a */
+#define OAFP_HAS_CREATE_TIME    0x0020  /* 0x19 */
+#define OAFP_HAS_DM_BUILD       0x0040  /* 0x1c */
+#define OAFP_HAS_BUILD_INFO     0x0080  /* 0x1d */
+#define OAFP_HAS_MAP_DELTA      0x0100  /* 0x1f */
+#define OAFP_HAS_MARKER         0x0200  /* 0x28 */
+
+typedef struct oafpResult {
+    char        magic[8];           /* "OAFPRSLT" */
+    uint32_t    version;            /* OAFP_RESULT_VERSION */
+    uint32_t    fileCount;
+    uint64_t    size;               /* Bytes in the whole block. */
+    uint64_t    filesOffset;        /* oafpFile[fileCount] */
+    uint32_t    recordSize;         /* sizeof(oafpFile) of the writer. */
+    uint32_t    failed;             /* Files with status != 0. */
+} oafpResult;
+
+typedef struct oafpTable {
+    uint64_t    id;
+    uint64_t    offset;
+    uint64_t    size;
+} oafpTable;
+
+/* One entry of the database map merged with its delta, sorted by id. */
+typedef struct oafpMapEntry {
+    uint64_t    id;
+    uint32_t    type;
+    uint32_t    dataTable;          /* 1 for data table entries. */
+} oafpMapEntry;
+
+typedef struct oafpFile {
+    uint64_t    pathOffset;
+    uint64_t    errorOffset;
+    int32_t     status;             /* 0 if the file parsed. */
+    uint32_t    present;            /* OAFP_HAS_* */
+
+    /* File header. */
+    uint32_t    testBit;
+    uint16_t    type;
+    uint16_t    schema;
+    uint64_t    offset;
+    uint32_t    size;
+    uint32_t    used;
+
+    uint64_t    tablesOffset;       /* oafpTable[tableCount] */
+    uint32_t    tableCount;
+
+    uint32_t    flags;
+    uint32_t    timeStamp;
+    uint32_t    marker;
+    uint64_t    lastSavedTime;
+    uint64_t    createTime;         /* Seconds, as printed by testParser. */
+
+    uint64_t    mapOffset;          /* oafpMapEntry[mapCount] */
+    uint32_t    mapCount;
+
+    /* String table: stringsSize bytes of NUL separated strings. */
+    uint32_t    stringCount;
+    uint64_t    stringsOffset;
+    uint32_t    stringsSize;
+    uint32_t    stringsDeleted;
+    uint32_t    stringsFirst;
+
+    uint16_t    dataModelRev;
+    uint16_t    appDataModelRev;
+    uint16_t    kitDataModelRev;
+    uint16_t    appAPIMinorRev;
+    uint16_t    kitReleaseNum;
+    uint16_t    reserved;           /* Keeps the offsets 8 byte aligned. */
+    uint64_t    buildNameOffset;
+    uint64_t    appBuildNameOffset;
+    uint64_t    kitBuildNameOffset;
+    uint64_t    platformNameOffset;
+} oafpFile;
+
+/*
+ * Parses count files on numThreads threads (0 for one per core) and stores
+ * the block in *result, in the order of paths.  Returns the number of
+ * files that failed to parse, or -1 if no block could be built or paths
+ * or result is NULL.  A block is returned even when files fail; their
+ * records carry the error.
+ */
+int oafpParseFiles(const char *const *paths, unsigned int count,
+                   unsigned int numThreads, oafpResult **result);
+
+void oafpFreeResult(oafpResult *result);
+
+static inline const void *oafpAt(const oafpResult *result, uint64_t offset)
+{
+    return offset!=0 ? (const char *)result + offset : 0;
+}
+
+static inline const oafpFile *oafpFileAt(const oafpResult *result,
+                                         unsigned int i)
+{
+    return (const oafpFile *)((const char *)result + result->filesOffset +
+                              (uint64_t)result->recordSize * i);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //OAFILEPARSERC_H_
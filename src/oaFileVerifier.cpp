@@ -0,0 +1,214 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaFileVerifier.h"
+#include "oaFileParser.h"
+#include "oaTableDecoders.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace oafp
+{
+    static verifyStatus fail(verifyReport &report, verifyStatus status,
+                             unsigned long table, unsigned long other,
+                             const char *message)
+    {
+        report.status = status;
+        report.table = table;
+        report.other = other;
+        report.message = message;
+        return status;
+    }
+
+    // Checks the counts at the start of the tables that hold arrays against
+    // the table sizes, and decodes the small fixed layout tables in full.
+    static const char *verifyTable(const tableDirectory &dir, unsigned int i,
+                                   std::vector<char> &buffer)
+    {
+        unsigned long id = dir.ids[i];
+        unsigned long size = dir.sizes[i];
+
+        try {
+            switch(id) {
+                case 0x07: {
+                    unsigned int counts[2];
+
+                    if(size<sizeof(counts)) {
+                        return "Database map is too small.";
+                    }
+
+                    if(dir.read(i, 0, (char *)counts, sizeof(counts))!=0) {
+                        return "Unable to read the database map.";
+                    }
+
+                    if(counts[1]<counts[0] || sizeof(counts) +
+                       (sizeof(unsigned long) + sizeof(unsigned int)) *
+                       (unsigned long)counts[1] > size) {
+                        return "Database map exceeds its table size.";
+                    }
+
+                    break;
+                }
+                case 0x0a: {
+                    tableIndex table;
+                    unsigned int empty;
+
+                    if(size<sizeof(table) + sizeof(empty)) {
+                        return "String table is too small.";
+                    }
+
+                    if(dir.read(i, 0, (char *)&table, sizeof(table))!=0) {
+                        return "Unable to read the string table.";
+                    }
+
+                    if(table.used>size - sizeof(table) - sizeof(empty)) {
+                        return "String table exceeds its table size.";
+                    }
+
+                    break;
+                }
+                case 0x1f: {
+                    unsigned long num;
+
+                    if(size<sizeof(num)) {
+                        return "Database map delta is too small.";
+                    }
+
+                    if(dir.read(i, 0, (char *)&num, sizeof(num))!=0) {
+                        return "Unable to read the database map delta.";
+                    }
+
+                    if(num > (size - sizeof(num)) /
+                       (sizeof(unsigned long) + sizeof(unsigned int))) {
+                        return "Database map delta exceeds its table size.";
+                    }
+
+                    break;
+                }
+                case 0x04:
+                case 0x05:
+                case 0x06:
+                case 0x19:
+                case 0x1c:
+                case 0x1d:
+                case 0x28: {
+                    buffer.resize(size + 1);
+
+                    if(dir.read(i, &buffer[0])!=0) {
+                        return "Unable to read the table.";
+                    }
+
+                    char *data = &buffer[0];
+                    auto ignore = [](auto &&...) {};
+
+                    if(id==0x04) {
+                        decode0x04(data, size, ignore);
+                    } else if(id==0x05) {
+                        decode0x05(data, size, ignore);
+                    } else if(id==0x06) {
+                        decode0x06(data, size, ignore);
+                    } else if(id==0x19) {
+                        decode0x19(data, size, ignore);
+                    } else if(id==0x1c) {
+                        decode0x1c(data, size, ignore);
+                    } else if(id==0x1d) {
+                        decode0x1d(data, size, ignore);
+                    } else {
+                        decode0x28(data, size, ignore);
+                    }
+
+                    break;
+                }
+            }
+        } catch(const char *error) {
+            return error;
+        }
+
+        return NULL;
+    }
+
+    verifyStatus verifyFile(const char *filePath, verifyReport &report)
+    {
+        tableDirectory dir;
+        fail(report, verifyOk, 0, 0, "");
+
+        int opened = dir.open(filePath);
+
+        if(opened<0) {
+            return fail(report, verifyUnreadable, 0, 0, "Unable to read the file.");
+        }
+
+        if(opened!=0) {
+            return fail(report, verifyBadIndex, 0, 0,
+                        "Header or table index runs past the end of the file.");
+        }
+
+        // Tables are stored after the index; 0x01 spans the tables that are
+        // positioned relative to it, so it takes no part in the overlap
+        // check.
+        unsigned long used = dir.header.used;
+        unsigned long indexEnd = sizeof(fileHeader) + sizeof(unsigned long) * used * 3;
+        std::vector<std::pair<unsigned long, unsigned int> > extents;
+        extents.reserve(used);
+
+        for(unsigned int i=0; i<used; ++i) {
+            unsigned long pos = dir.position(i);
+
+            if(pos<indexEnd || pos>dir.fileSize || dir.sizes[i]>dir.fileSize - pos) {
+                return fail(report, verifyTableOutOfRange, dir.ids[i], 0,
+                            "Table lies outside the file.");
+            }
+
+            if(dir.ids[i]!=0x01 && dir.sizes[i]!=0) {
+                extents.push_back(std::make_pair(pos, i));
+            }
+        }
+
+        std::sort(extents.begin(), extents.end());
+
+        for(size_t e=1; e<extents.size(); ++e) {
+            unsigned int prev = extents[e - 1].second;
+
+            if(extents[e - 1].first + dir.sizes[prev]>extents[e].first) {
+                return fail(report, verifyTableOverlap, dir.ids[prev],
+                            dir.ids[extents[e].second], "Tables overlap.");
+            }
+        }
+
+        std::vector<char> buffer;
+
+        for(unsigned int i=0; i<used; ++i) {
+            const char *error = verifyTable(dir, i, buffer);
+
+            if(error!=NULL) {
+                return fail(report, verifyBadTable, dir.ids[i], 0, error);
+            }
+        }
+
+        return verifyOk;
+    }
+} //End namespace oafp
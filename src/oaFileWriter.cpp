@@ -0,0 +1,305 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaFileWriter.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace oafp
+{
+    // Source of the padding between tables.
+    static const char zeros[8] = {0};
+
+    static unsigned long align8(unsigned long size)
+    {
+        return (size + 7) & ~7ul;
+    }
+
+    // Writes all of iov, IOV_MAX pieces at a time, resuming partial writes.
+    static int writeAll(int fd, std::vector<struct iovec> &iov)
+    {
+        size_t i = 0;
+
+        while(i<iov.size()) {
+            int num = std::min<size_t>(iov.size() - i, IOV_MAX);
+            ssize_t out = writev(fd, &iov[i], num);
+
+            if(out<0 && errno==EINTR) {
+                continue;
+            }
+
+            if(out<0) {
+                return 1;
+            }
+
+            for(; i<iov.size() && (size_t)out>=iov[i].iov_len; ++i) {
+                out -= iov[i].iov_len;
+            }
+
+            if(out>0) {
+                iov[i].iov_base = (char *)iov[i].iov_base + out;
+                iov[i].iov_len -= out;
+            }
+        }
+
+        return 0;
+    }
+
+    oaFileWriter::oaFileWriter()
+    {
+        memset(&header, 0, sizeof(header));
+        header.testBit = 0x01020304;
+        header.type = 0x1;
+        header.schema = 0x4;
+    }
+
+    void oaFileWriter::setHeader(unsigned int testBit, unsigned short type,
+                                 unsigned short schema)
+    {
+        header.testBit = testBit;
+        header.type = type;
+        header.schema = schema;
+    }
+
+    void oaFileWriter::beginTable(unsigned long id)
+    {
+        writerTable table = {id, 0, pieces.size(), 0};
+        tables.push_back(table);
+    }
+
+    void oaFileWriter::addPiece(const void *data, unsigned long size)
+    {
+        struct iovec piece;
+        piece.iov_base = (void *)data;
+        piece.iov_len = size;
+        pieces.push_back(piece);
+        tables.back().size += size;
+        tables.back().num += 1;
+    }
+
+    void oaFileWriter::addName(const char *name)
+    {
+        // NUL plus up to 8 bytes of padding, as roundAlign8Bit() skips.
+        size_t len = strlen(name);
+        addPiece(name, len);
+        addPiece(zeros, 8 - len%8);
+    }
+
+    void oaFileWriter::addTable(unsigned long id, const void *data,
+                                unsigned long size)
+    {
+        beginTable(id);
+        addPiece(data, size);
+    }
+
+    void oaFileWriter::addFlags(unsigned int flags)
+    {
+        beginTable(0x04);
+        addValue(flags);
+    }
+
+    void oaFileWriter::addTimeStamp(unsigned int timeStamp)
+    {
+        beginTable(0x05);
+        addValue(timeStamp);
+    }
+
+    void oaFileWriter::addLastSavedTime(unsigned long lastSavedTime)
+    {
+        beginTable(0x06);
+        addValue(lastSavedTime);
+    }
+
+    void oaFileWriter::addDatabaseMap(const unsigned long ids[],
+                                      const unsigned int types[], unsigned int idCount,
+                                      const unsigned long tblIds[], const unsigned int tblTypes[],
+                                      unsigned int tblCount)
+    {
+        beginTable(0x07);
+        addValue(idCount);
+        addValue(idCount + tblCount);
+        addPiece(ids, sizeof(ids[0]) * idCount);
+        addPiece(types, sizeof(types[0]) * idCount);
+        addPiece(tblIds, sizeof(tblIds[0]) * tblCount);
+        addPiece(tblTypes, sizeof(tblTypes[0]) * tblCount);
+    }
+
+    void oaFileWriter::addStringTable(const tableIndex &table, const char *strings)
+    {
+        beginTable(0x0a);
+        addValue(table);
+        addValue<unsigned int>(0);
+        addPiece(strings, table.used);
+    }
+
+    void oaFileWriter::addCreateTime(unsigned long createTime)
+    {
+        beginTable(0x19);
+        addValue(createTime);
+    }
+
+    void oaFileWriter::addDMandBuildName(unsigned short dataModelRev,
+                                         const char *buildName)
+    {
+        beginTable(0x1c);
+        addValue(dataModelRev);
+        addName(buildName);
+    }
+
+    void oaFileWriter::addBuildInformation(unsigned short appDataModelRev,
+                                           unsigned short kitDataModelRev,
+                                           unsigned short appAPIMinorRev,
+                                           unsigned short kitReleaseNum,
+                                           const char *appBuildName,
+                                           const char *kitBuildName,
+                                           const char *platforName)
+    {
+        appInfo ai = {appDataModelRev, kitDataModelRev, appAPIMinorRev, kitReleaseNum};
+        beginTable(0x1d);
+        addValue(ai);
+        addName(appBuildName);
+        addName(kitBuildName);
+        addName(platforName);
+    }
+
+    void oaFileWriter::addDatabaseMapD(const unsigned long ids[],
+                                       const unsigned int types[], unsigned long num)
+    {
+        beginTable(0x1f);
+        addValue(num);
+        addPiece(ids, sizeof(ids[0]) * num);
+        addPiece(types, sizeof(types[0]) * num);
+    }
+
+    void oaFileWriter::addDatabaseMarker(unsigned int bitCheck)
+    {
+        beginTable(0x28);
+        addValue(bitCheck);
+    }
+
+    int oaFileWriter::write(const char *filePath)
+    {
+        int fd = ::open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        if(fd<0) {
+            return 1;
+        }
+
+        int status = write(fd);
+        return (::close(fd)==0 && status==0) ? 0 : 1;
+    }
+
+    int oaFileWriter::write(int fd)
+    {
+        unsigned int used = tables.size() + 1;
+        unsigned long indexEnd = sizeof(header) + sizeof(unsigned long) * used * 3;
+        unsigned long startOffset = align8(indexEnd);
+        std::vector<unsigned long> ids(used);
+        std::vector<unsigned long> offsets(used);
+        std::vector<unsigned long> sizes(used);
+        std::vector<unsigned int> order;
+
+        // Tables relative to 0x01 first, then the string tables, each table
+        // padded up to the next one.
+        unsigned long body = 0;
+
+        for(unsigned int t=0; t<tables.size(); ++t) {
+            if(tables[t].id!=0x0a) {
+                offsets[t + 1] = body;
+                body += align8(tables[t].size);
+                order.push_back(t);
+            }
+        }
+
+        unsigned long pos = startOffset + body;
+
+        for(unsigned int t=0; t<tables.size(); ++t) {
+            if(tables[t].id==0x0a) {
+                offsets[t + 1] = pos;
+                pos += align8(tables[t].size);
+                order.push_back(t);
+            }
+        }
+
+        ids[0] = 0x01;
+        offsets[0] = startOffset;
+        sizes[0] = body;
+
+        for(unsigned int t=0; t<tables.size(); ++t) {
+            ids[t + 1] = tables[t].id;
+            sizes[t + 1] = tables[t].size;
+        }
+
+        fileHeader fh = header;
+        fh.offset = sizeof(fh);
+        fh.size = used;
+        fh.used = used;
+
+        std::vector<struct iovec> iov;
+        iov.reserve(pieces.size() + tables.size() + 5);
+        struct iovec piece;
+        piece.iov_base = &fh;
+        piece.iov_len = sizeof(fh);
+        iov.push_back(piece);
+        piece.iov_base = ids.data();
+        piece.iov_len = sizeof(ids[0]) * used;
+        iov.push_back(piece);
+        piece.iov_base = offsets.data();
+        iov.push_back(piece);
+        piece.iov_base = sizes.data();
+        iov.push_back(piece);
+        piece.iov_base = (void *)zeros;
+        piece.iov_len = startOffset - indexEnd;
+        iov.push_back(piece);
+
+        // The file ends right after a trailing string table, while the
+        // tables in 0x01 always fill its padded size.
+        for(size_t o=0; o<order.size(); ++o) {
+            const writerTable &table = tables[order[o]];
+            iov.insert(iov.end(), pieces.begin() + table.first,
+                       pieces.begin() + table.first + table.num);
+
+            if(o + 1<order.size() || table.id!=0x0a) {
+                piece.iov_base = (void *)zeros;
+                piece.iov_len = align8(table.size) - table.size;
+                iov.push_back(piece);
+            }
+        }
+
+        return writeAll(fd, iov);
+    }
+
+    void oaFileWriter::clear()
+    {
+        tables.clear();
+        pieces.clear();
+        arena.reset();
+    }
+} //End namespace oafp
@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaLibraryScanner.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace oafp
+{
+    bool isLibraryFile(const char *name)
+    {
+        size_t len = strlen(name);
+
+        if(strcmp(name, "tech.db")==0) {
+            return true;
+        }
+
+        return len>3 && (strcmp(&name[len-3], ".oa")==0 ||
+                         strcmp(&name[len-3], ".dm")==0);
+    }
+
+    static void walkLibrary(const std::string &dir, std::vector<std::string> &files)
+    {
+        DIR *d = opendir(dir.c_str());
+
+        if(d==NULL) {
+            return;
+        }
+
+        struct dirent *entry;
+
+        while((entry = readdir(d))!=NULL) {
+            if(strcmp(entry->d_name, ".")==0 || strcmp(entry->d_name, "..")==0) {
+                continue;
+            }
+
+            std::string path = dir + "/" + entry->d_name;
+            unsigned char type = entry->d_type;
+
+            if(type==DT_UNKNOWN) {
+                struct stat st;
+
+                if(lstat(path.c_str(), &st)!=0) {
+                    continue;
+                }
+
+                type = S_ISDIR(st.st_mode) ? DT_DIR : (S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN);
+            }
+
+            if(type==DT_DIR) {
+                walkLibrary(path, files);
+            } else if(type==DT_REG && isLibraryFile(entry->d_name)) {
+                files.push_back(path);
+            }
+        }
+
+        closedir(d);
+    }
+
+    int findLibraryFiles(const char *root, std::vector<std::string> &files)
+    {
+        struct stat st;
+
+        if(stat(root, &st)!=0) {
+            return 1;
+        }
+
+        if(!S_ISDIR(st.st_mode)) {
+            files.push_back(root);
+            return 0;
+        }
+
+        std::string dir(root);
+
+        while(dir.size()>1 && dir[dir.size()-1]=='/') {
+            dir.erase(dir.size()-1);
+        }
+
+        walkLibrary(dir, files);
+        std::sort(files.begin(), files.end());
+        return 0;
+    }
+
+    struct scanQueue {
+        std::mutex          lock;
+        std::deque<size_t>  tasks;
+    };
+
+    struct scanSlot {
+        bool                done;
+        int                 status;
+        std::string         result;
+        std::string         error;
+    };
+
+    oaLibraryScanner::oaLibraryScanner(unsigned int numThreads)
+        : numThreads(numThreads)
+    {
+        if(this->numThreads==0) {
+            this->numThreads = std::thread::hardware_concurrency();
+        }
+
+        if(this->numThreads==0) {
+            this->numThreads = 1;
+        }
+    }
+
+    oaLibraryScanner::~oaLibraryScanner()
+    {
+    }
+
+    unsigned int oaLibraryScanner::threads() const
+    {
+        return numThreads;
+    }
+
+    int oaLibraryScanner::scan(const char *root)
+    {
+        std::vector<std::string> files;
+
+        if(findLibraryFiles(root, files)!=0) {
+            return -1;
+        }
+
+        return scan(files);
+    }
+
+    int oaLibraryScanner::scan(const std::vector<std::string> &files)
+    {
+        unsigned int n = std::min<size_t>(numThreads, std::max<size_t>(files.size(), 1));
+        std::vector<scanQueue> queues(n);
+        std::vector<scanSlot> slots(files.size());
+        std::mutex mergeLock;
+        size_t nextMerge = 0;
+        int failed = 0;
+
+        for(size_t i=0; i<files.size(); ++i) {
+            queues[i % n].tasks.push_back(i);
+            slots[i].done = false;
+        }
+
+        auto nextTask = [&](unsigned int worker, size_t &task) {
+            {
+                std::lock_guard<std::mutex> guard(queues[worker].lock);
+
+                if(!queues[worker].tasks.empty()) {
+                    task = queues[worker].tasks.front();
+                    queues[worker].tasks.pop_front();
+                    return true;
+                }
+            }
+
+            for(unsigned int v=1; v<n; ++v) {
+                scanQueue &victim = queues[(worker + v) % n];
+                std::lock_guard<std::mutex> guard(victim.lock);
+
+                if(!victim.tasks.empty()) {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+        auto work = [&](unsigned int worker) {
+            size_t task;
+
+            while(nextTask(worker, task)) {
+                scanSlot &slot = slots[task];
+                int status;
+
+                try {
+                    status = onScanFile(worker, files[task], slot.result, slot.error);
+                } catch(...) {
+                    status = 1;
+                }
+
+                std::lock_guard<std::mutex> guard(mergeLock);
+                slot.status = status;
+                slot.done = true;
+
+                while(nextMerge<slots.size() && slots[nextMerge].done) {
+                    scanSlot &ready = slots[nextMerge];
+                    onScanResult(files[nextMerge], ready.status, ready.result, ready.error);
+
+                    if(ready.status!=0) {
+                        ++failed;
+                    }
+
+                    std::string().swap(ready.result);
+                    std::string().swap(ready.error);
+                    ++nextMerge;
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+
+        for(unsigned int w=1; w<n; ++w) {
+            workers.push_back(std::thread(work, w));
+        }
+
+        work(0);
+
+        for(size_t w=0; w<workers.size(); ++w) {
+            workers[w].join();
+        }
+
+        return failed;
+    }
+} //End namespace oafp
@@ -0,0 +1,73 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OALIBRARYSCANNER_H_
+#define OALIBRARYSCANNER_H_
+
+#include <string>
+#include <vector>
+
+namespace oafp
+{
+    // True for the file names findLibraryFiles() picks up.
+    bool isLibraryFile(const char *name);
+
+    // Collects the OpenAccess files (*.oa, *.dm and tech.db) below root in
+    // sorted order.  A root that names a single file is returned as is.
+    int findLibraryFiles(const char *root, std::vector<std::string> &files);
+
+    // Runs onScanFile() for every file of a library on a work stealing
+    // thread pool.  Each worker starts with every n-th file so the pool
+    // moves through the library roughly in order, and an idle worker steals
+    // from the tail of the next non-empty queue after its own, in round
+    // robin order.  onScanResult() is called one file at a time, in sorted
+    // path order, as soon as the results of all earlier files are in.
+    class oaLibraryScanner
+    {
+    public:
+        oaLibraryScanner(unsigned int numThreads = 0);
+        virtual ~oaLibraryScanner();
+
+        // Returns the number of files whose scan failed, or -1 if the
+        // library could not be read.
+        int scan(const char *root);
+        int scan(const std::vector<std::string> &files);
+
+        unsigned int threads() const;
+
+    protected:
+        // Called concurrently from the worker threads.
+        virtual int onScanFile(unsigned int worker, const std::string &path,
+                               std::string &result, std::string &error) = 0;
+        // Called from one thread at a time, in file order.
+        virtual void onScanResult(const std::string &path, int status,
+                                  const std::string &result, const std::string &error) = 0;
+
+    private:
+        unsigned int        numThreads;
+    };
+
+} // End namespace oafp
+
+#endif //OALIBRARYSCANNER_H_
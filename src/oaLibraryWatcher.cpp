@@ -0,0 +1,275 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaLibraryWatcher.h"
+#include "oaLibraryScanner.h"
+
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace oafp
+{
+    static const unsigned int watchMask = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                          IN_MOVED_FROM | IN_DELETE | IN_CREATE | IN_DELETE_SELF | IN_ONLYDIR;
+
+    // Builds the first catalog on the scanner's thread pool.
+    class oaLibraryWatcher::catalogScanner : public oaLibraryScanner
+    {
+    public:
+        catalogScanner(oaLibraryWatcher &watcher)
+            : oaLibraryScanner(watcher.numThreads), watcher(watcher) {
+        };
+
+    protected:
+        virtual int onScanFile(unsigned int worker, const std::string &path,
+                               std::string &result, std::string &error) {
+            return watcher.onParseFile(path, result);
+        };
+        virtual void onScanResult(const std::string &path, int status,
+                                  const std::string &result, const std::string &error) {
+            catalogEntry &entry = watcher.entries[path];
+            entry.status = status;
+            entry.result = result;
+            watcher.onFileChanged(fileAdded, path, entry);
+        };
+
+    private:
+        oaLibraryWatcher &watcher;
+    };
+
+    oaLibraryWatcher::oaLibraryWatcher(unsigned int numThreads)
+        : numThreads(numThreads), fd(-1), stopped(false)
+    {
+    }
+
+    oaLibraryWatcher::~oaLibraryWatcher()
+    {
+        if(fd>=0) {
+            close(fd);
+        }
+    }
+
+    void oaLibraryWatcher::stop()
+    {
+        stopped = true;
+    }
+
+    const std::map<std::string, oaLibraryWatcher::catalogEntry>
+    &oaLibraryWatcher::catalog() const
+    {
+        return entries;
+    }
+
+    void oaLibraryWatcher::addWatches(const std::string &dir,
+                                      std::set<std::string> *found)
+    {
+        int wd = inotify_add_watch(fd, dir.c_str(), watchMask);
+
+        if(wd<0) {
+            return;
+        }
+
+        watches[wd] = dir;
+        DIR *d = opendir(dir.c_str());
+
+        if(d==NULL) {
+            return;
+        }
+
+        struct dirent *entry;
+
+        while((entry = readdir(d))!=NULL) {
+            if(strcmp(entry->d_name, ".")==0 || strcmp(entry->d_name, "..")==0) {
+                continue;
+            }
+
+            std::string path = dir + "/" + entry->d_name;
+            struct stat st;
+
+            if(lstat(path.c_str(), &st)!=0) {
+                continue;
+            }
+
+            if(S_ISDIR(st.st_mode)) {
+                addWatches(path, found);
+            } else if(S_ISREG(st.st_mode) && isLibraryFile(entry->d_name) &&
+                      found!=NULL) {
+                found->insert(path);
+            }
+        }
+
+        closedir(d);
+    }
+
+    void oaLibraryWatcher::update(const std::string &path)
+    {
+        std::map<std::string, catalogEntry>::iterator it = entries.find(path);
+        struct stat st;
+
+        if(stat(path.c_str(), &st)!=0 || !S_ISREG(st.st_mode)) {
+            if(it!=entries.end()) {
+                catalogEntry entry = it->second;
+                entries.erase(it);
+                onFileChanged(fileRemoved, path, entry);
+            }
+
+            return;
+        }
+
+        bool added = it==entries.end();
+        catalogEntry &entry = entries[path];
+        entry.result.clear();
+        entry.status = onParseFile(path, entry.result);
+        onFileChanged(added ? fileAdded : fileModified, path, entry);
+    }
+
+    void oaLibraryWatcher::readEvents(std::set<std::string> &changed)
+    {
+        char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t len;
+
+        while((len = read(fd, buffer, sizeof(buffer)))>0) {
+            for(char *b = buffer; b<buffer + len;) {
+                const struct inotify_event *event = (const struct inotify_event *)b;
+                b += sizeof(struct inotify_event) + event->len;
+
+                if(event->mask & IN_Q_OVERFLOW) {
+                    // Events were lost: look at every known and present file.
+                    for(std::map<std::string, catalogEntry>::const_iterator it =
+                            entries.begin(); it!=entries.end(); ++it) {
+                        changed.insert(it->first);
+                    }
+
+                    addWatches(root, &changed);
+                    continue;
+                }
+
+                std::map<int, std::string>::iterator w = watches.find(event->wd);
+
+                if(w==watches.end()) {
+                    continue;
+                }
+
+                if(event->mask & (IN_IGNORED | IN_DELETE_SELF)) {
+                    watches.erase(w);
+                    continue;
+                }
+
+                if(event->len==0) {
+                    continue;
+                }
+
+                std::string path = w->second + "/" + event->name;
+
+                if(event->mask & IN_ISDIR) {
+                    if(event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        addWatches(path, &changed);
+                    } else if(event->mask & IN_MOVED_FROM) {
+                        std::string prefix = path + "/";
+
+                        // The watches would follow the directory under its
+                        // old name; a matching IN_MOVED_TO adds them again.
+                        for(std::map<int, std::string>::const_iterator it = watches.begin();
+                            it!=watches.end(); ++it) {
+                            if(it->second==path || it->second.compare(0, prefix.size(), prefix)==0) {
+                                inotify_rm_watch(fd, it->first);
+                            }
+                        }
+
+                        for(std::map<std::string, catalogEntry>::const_iterator it =
+                                entries.lower_bound(prefix);
+                            it!=entries.end() && it->first.compare(0, prefix.size(), prefix)==0; ++it) {
+                            changed.insert(it->first);
+                        }
+                    }
+                } else if(isLibraryFile(event->name) &&
+                          (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE))) {
+                    changed.insert(path);
+                }
+            }
+        }
+    }
+
+    int oaLibraryWatcher::watch(const char *root)
+    {
+        if(fd>=0) {
+            close(fd);
+        }
+
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        if(fd<0) {
+            return 1;
+        }
+
+        this->root = root;
+
+        while(this->root.size()>1 && this->root[this->root.size()-1]=='/') {
+            this->root.erase(this->root.size()-1);
+        }
+
+        // Watches go in before the first scan so no save can slip through.
+        std::set<std::string> found;
+        entries.clear();
+        watches.clear();
+        addWatches(this->root, &found);
+
+        if(watches.empty()) {
+            return 1;
+        }
+
+        catalogScanner scanner(*this);
+        scanner.scan(std::vector<std::string>(found.begin(), found.end()));
+
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+
+        while(!stopped) {
+            if(poll(&pfd, 1, 250)<=0) {
+                continue;
+            }
+
+            // Keep collecting until the library has been quiet for a moment.
+            std::set<std::string> changed;
+
+            do {
+                readEvents(changed);
+            } while(!stopped && poll(&pfd, 1, 50)>0);
+
+            for(std::set<std::string>::const_iterator it = changed.begin();
+                it!=changed.end() && !stopped; ++it) {
+                update(*it);
+            }
+        }
+
+        return 0;
+    }
+} //End namespace oafp
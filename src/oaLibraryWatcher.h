@@ -0,0 +1,89 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OALIBRARYWATCHER_H_
+#define OALIBRARYWATCHER_H_
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+
+namespace oafp
+{
+    // Keeps a catalog with one parse result per library file and re-parses
+    // only the files inotify reports as written, moved or deleted.  The
+    // events that arrive together are coalesced, so a save that touches a
+    // file several times parses it once.
+    class oaLibraryWatcher
+    {
+    public:
+        enum changeType {
+            fileAdded,
+            fileModified,
+            fileRemoved
+        };
+
+        struct catalogEntry {
+            int             status;
+            std::string     result;
+        };
+
+        oaLibraryWatcher(unsigned int numThreads = 0);
+        virtual ~oaLibraryWatcher();
+
+        // Builds the catalog, reporting every file as added, and then
+        // follows changes until stop() is called.  Returns 1 if the library
+        // cannot be watched.
+        int watch(const char *root);
+        // Safe to call from a signal handler or another thread.
+        void stop();
+
+        const std::map<std::string, catalogEntry> &catalog() const;
+
+    protected:
+        // Called on the scanner's worker threads while the catalog is first
+        // built and on the watching thread afterwards.
+        virtual int onParseFile(const std::string &path, std::string &result) = 0;
+        virtual void onFileChanged(changeType change, const std::string &path,
+                                   const catalogEntry &entry) = 0;
+
+    private:
+        class catalogScanner;
+
+        void addWatches(const std::string &dir, std::set<std::string> *found);
+        void update(const std::string &path);
+        void readEvents(std::set<std::string> &changed);
+
+        std::map<std::string, catalogEntry>     entries;
+        std::map<int, std::string>              watches;
+        std::string                             root;
+        unsigned int                            numThreads;
+        int                                     fd;
+        std::atomic<bool>                       stopped;
+    };
+
+} // End namespace oafp
+
+#endif //OALIBRARYWATCHER_H_
@@ -0,0 +1,163 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaOutputBuffer.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace oafp
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    oaOutputBuffer::oaOutputBuffer(int fd, size_t capacity)
+        : fd(fd), buffer(NULL), used(0), capacity(capacity)
+    {
+        buffer = (char *)malloc(capacity);
+
+        if(buffer==NULL) {
+            throw std::bad_alloc();
+        }
+    }
+
+    oaOutputBuffer::~oaOutputBuffer()
+    {
+        flush();
+        free(buffer);
+    }
+
+    void oaOutputBuffer::appendUInt(unsigned long value)
+    {
+        char digits[20];
+        char *d = digits + sizeof(digits);
+
+        do {
+            *--d = '0' + value % 10;
+            value /= 10;
+        } while(value!=0);
+
+        append(d, digits + sizeof(digits) - d);
+    }
+
+    void oaOutputBuffer::appendHex(unsigned long value, unsigned int width)
+    {
+        char digits[16];
+        char *d = digits + sizeof(digits);
+
+        if(width>sizeof(digits)) {
+            width = sizeof(digits);
+        }
+
+        do {
+            *--d = hexDigits[value & 0xf];
+            value >>= 4;
+        } while(value!=0);
+
+        while(d>digits + sizeof(digits) - width) {
+            *--d = '0';
+        }
+
+        append(d, digits + sizeof(digits) - d);
+    }
+
+    void oaOutputBuffer::appendString(const char *text, size_t len)
+    {
+        // Worst case every byte becomes a six byte \u escape.
+        reserve(len * 6 + 2);
+        char *out = buffer + used;
+        *out++ = '"';
+
+        for(size_t i=0; i<len; ++i) {
+            unsigned char c = text[i];
+
+            if(c=='"' || c=='\\') {
+                *out++ = '\\';
+                *out++ = c;
+            } else if(c<0x20) {
+                *out++ = '\\';
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hexDigits[c >> 4];
+                *out++ = hexDigits[c & 0xf];
+            } else {
+                *out++ = c;
+            }
+        }
+
+        *out++ = '"';
+        used = out - buffer;
+    }
+
+    int oaOutputBuffer::flush()
+    {
+        if(fd<0) {
+            return 0;
+        }
+
+        size_t done = 0;
+
+        while(done<used) {
+            ssize_t out = write(fd, buffer + done, used - done);
+
+            if(out<0 && errno==EINTR) {
+                continue;
+            }
+
+            if(out<=0) {
+                used = 0;
+                return 1;
+            }
+
+            done += out;
+        }
+
+        used = 0;
+        return 0;
+    }
+
+    void oaOutputBuffer::grow(size_t len)
+    {
+        if(fd>=0 && flush()==0 && len<=capacity) {
+            return;
+        }
+
+        size_t size = capacity * 2;
+
+        while(len>size - used) {
+            size *= 2;
+        }
+
+        char *bigger = (char *)realloc(buffer, size);
+
+        if(bigger==NULL) {
+            throw std::bad_alloc();
+        }
+
+        buffer = bigger;
+        capacity = size;
+    }
+} //End namespace oafp
@@ -0,0 +1,98 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OAOUTPUTBUFFER_H_
+#define OAOUTPUTBUFFER_H_
+
+#include <cstddef>
+#include <cstring>
+
+namespace oafp
+{
+    // Append-only text buffer for machine-readable reports.  Numbers are
+    // formatted by hand and nothing is written until flush(), so a report
+    // costs neither locale lookups nor a flush per line.  With a file
+    // descriptor the buffer drains itself once it grows past its capacity;
+    // without one it simply grows and is handed on through data() and size().
+    class oaOutputBuffer
+    {
+    public:
+        oaOutputBuffer(int fd = -1, size_t capacity = 1024 * 1024);
+        ~oaOutputBuffer();
+
+        void append(const char *text, size_t len) {
+            reserve(len);
+            memcpy(buffer + used, text, len);
+            used += len;
+        };
+        void append(const char *text) {
+            append(text, strlen(text));
+        };
+        void append(char c) {
+            reserve(1);
+            buffer[used++] = c;
+        };
+        void appendUInt(unsigned long value);
+        // Lower case hex, zero padded to at least width digits, with no
+        // "0x" prefix.
+        void appendHex(unsigned long value, unsigned int width = 0);
+        // Appends text as a quoted JSON string.
+        void appendString(const char *text, size_t len);
+        void appendString(const char *text) {
+            appendString(text, strlen(text));
+        };
+
+        const char *data() const {
+            return buffer;
+        };
+        size_t size() const {
+            return used;
+        };
+        void clear() {
+            used = 0;
+        };
+
+        // Writes out and clears the buffer; returns 1 on a write error.
+        int flush();
+
+    private:
+        oaOutputBuffer(const oaOutputBuffer &);
+        oaOutputBuffer &operator=(const oaOutputBuffer &);
+
+        void reserve(size_t len) {
+            if(len>capacity - used) {
+                grow(len);
+            }
+        };
+        void grow(size_t len);
+
+        int                 fd;
+        char               *buffer;
+        size_t              used;
+        size_t              capacity;
+    };
+
+} // End namespace oafp
+
+#endif //OAOUTPUTBUFFER_H_
@@ -0,0 +1,570 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaParseCache.h"
+#include "oaDatabaseMap.h"
+#include "oaFileParser.h"
+#include "oaStringTable.h"
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#include <sys/stat.h>
+
+namespace oafp
+{
+    static const char cacheMagic[8] = {'O', 'A', 'F', 'P', 'C', 'A', 'C', 'H'};
+    static const unsigned int cacheVersion = 2;
+
+    // Every record is a one byte kind, a four byte payload length and the
+    // payload: the callback arguments in order, with arrays written after
+    // the counts that size them and strings NUL terminated.
+    enum cacheRecord {
+        recordPreface = 1,
+        recordTableInformation,
+        recordFlags,
+        recordTimeStamp,
+        recordLastSavedTime,
+        recordDatabaseMap,
+        recordStringTable,
+        recordCreateTime,
+        recordDMandBuildName,
+        recordBuildInformation,
+        recordDatabaseMapD,
+        recordDatabaseMarker,
+        recordError
+    };
+
+    class recordWriter
+    {
+    public:
+        recordWriter(std::string &out, cacheRecord kind)
+            : out(out), start(out.size()) {
+            unsigned char k = kind;
+            unsigned int len = 0;
+            put(&k, sizeof(k));
+            put(&len, sizeof(len));
+        };
+        ~recordWriter() {
+            unsigned int len = out.size() - start - 1 - sizeof(len);
+            memcpy(&out[start + 1], &len, sizeof(len));
+        };
+
+        void put(const void *data, size_t size) {
+            out.append((const char *)data, size);
+        };
+        template<typename T>
+        void value(T v) {
+            put(&v, sizeof(v));
+        };
+        void string(const char *str) {
+            put(str, strlen(str) + 1);
+        };
+
+    private:
+        std::string    &out;
+        size_t          start;
+    };
+
+    class recordReader
+    {
+    public:
+        recordReader(const char *data, size_t size)
+            : b(data), end(data + size) {
+        };
+
+        const char *get(size_t size) {
+            if(size>(size_t)(end - b)) {
+                throw("Cache record is truncated.");
+            }
+
+            const char *p = b;
+            b += size;
+            return p;
+        };
+        template<typename T>
+        T value() {
+            T v;
+            memcpy(&v, get(sizeof(v)), sizeof(v));
+            return v;
+        };
+        const char *string() {
+            const char *str = b;
+            const char *nul = (const char *)memchr(b, '\0', end - b);
+
+            if(nul==NULL) {
+                throw("Cache record is truncated.");
+            }
+
+            b = nul + 1;
+            return str;
+        };
+        bool done() const {
+            return b==end;
+        };
+
+    private:
+        const char     *b;
+        const char     *end;
+    };
+
+    // Parses a file once and records every callback.
+    class cacheRecorder : public oaFileParser
+    {
+    public:
+        cacheRecorder() {
+            setIndexStrings(true);
+        };
+
+        std::string records;
+
+    protected:
+        virtual void onParsedPreface(unsigned int testBit, unsigned short type,
+                                     unsigned short schema, unsigned long offset, unsigned int size,
+                                     unsigned int used) {
+            recordWriter r(records, recordPreface);
+            r.value(testBit);
+            r.value(type);
+            r.value(schema);
+            r.value(offset);
+            r.value(size);
+            r.value(used);
+        };
+        virtual void onParsedTableInformation(unsigned long ids[],
+                                              unsigned long offsets[], unsigned long sizes[], unsigned int num) {
+            recordWriter r(records, recordTableInformation);
+            r.value(num);
+            r.put(ids, sizeof(ids[0]) * num);
+            r.put(offsets, sizeof(offsets[0]) * num);
+            r.put(sizes, sizeof(sizes[0]) * num);
+        };
+        virtual void onParsedFlags(unsigned int flags) {
+            recordWriter(records, recordFlags).value(flags);
+        };
+        virtual void onParsedTimeStamp(unsigned int timeStamp) {
+            recordWriter(records, recordTimeStamp).value(timeStamp);
+        };
+        virtual void onParsedLastSavedTime(unsigned long lastSavedTime) {
+            recordWriter(records, recordLastSavedTime).value(lastSavedTime);
+        };
+        virtual void onParsedDatabaseMap(unsigned long ids[], unsigned int types[],
+                                         unsigned int idCount, unsigned long tblIds[],
+                                         unsigned int tblTypes[], unsigned int tblCount) {
+            recordWriter r(records, recordDatabaseMap);
+            r.value(idCount);
+            r.value(tblCount);
+            r.put(ids, sizeof(ids[0]) * idCount);
+            r.put(types, sizeof(types[0]) * idCount);
+            r.put(tblIds, sizeof(tblIds[0]) * tblCount);
+            r.put(tblTypes, sizeof(tblTypes[0]) * tblCount);
+        };
+        virtual void onParsedStringTable(tableIndex table, const char *buffer) {
+        };
+        virtual void onParsedStringTableIndex(const oaStringTable &strings) {
+            recordWriter r(records, recordStringTable);
+            r.value(strings.table());
+            r.put(strings.data(), strings.table().used);
+        };
+        virtual void onParsedCreateTime(unsigned long createTime) {
+            recordWriter(records, recordCreateTime).value(createTime);
+        };
+        virtual void onParsedDMandBuildName(unsigned short dataModelRev,
+                                            const char *buildName) {
+            recordWriter r(records, recordDMandBuildName);
+            r.value(dataModelRev);
+            r.string(buildName);
+        };
+        virtual void onParsedBuildInformation(unsigned short appDataModelRev,
+                                              unsigned short kitDataModelRev, unsigned short appAPIMinorRev,
+                                              unsigned short kitReleaseNum, const char *appBuildName,
+                                              const char *kitBuildName, const char *platforName) {
+            recordWriter r(records, recordBuildInformation);
+            r.value(appDataModelRev);
+            r.value(kitDataModelRev);
+            r.value(appAPIMinorRev);
+            r.value(kitReleaseNum);
+            r.string(appBuildName);
+            r.string(kitBuildName);
+            r.string(platforName);
+        };
+        virtual void onParsedDatabaseMapD(unsigned long ids[], unsigned int types[],
+                                          unsigned long num) {
+            recordWriter r(records, recordDatabaseMapD);
+            r.value(num);
+            r.put(ids, sizeof(ids[0]) * num);
+            r.put(types, sizeof(types[0]) * num);
+        };
+        virtual void onParsedDatabaseMarker(unsigned int bitCheck) {
+            recordWriter(records, recordDatabaseMarker).value(bitCheck);
+        };
+        virtual void onParsedError(const char *error) {
+            recordWriter(records, recordError).string(error);
+        };
+    };
+
+    static bool readKey(const char *filePath, fileKey &key)
+    {
+        struct stat st;
+
+        if(stat(filePath, &st)!=0) {
+            return false;
+        }
+
+        key.size = st.st_size;
+        key.mtimeSec = st.st_mtim.tv_sec;
+        key.mtimeNsec = st.st_mtim.tv_nsec;
+        key.inode = st.st_ino;
+        key.device = st.st_dev;
+        return true;
+    }
+
+    static bool sameKey(const fileKey &a, const fileKey &b)
+    {
+        return a.size==b.size && a.mtimeSec==b.mtimeSec && a.mtimeNsec==b.mtimeNsec &&
+               a.inode==b.inode && a.device==b.device;
+    }
+
+    oaParseCache::oaParseCache()
+        : numHits(0), numMisses(0)
+    {
+    }
+
+    int oaParseCache::load(const char *cachePath)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        entries.clear();
+        FILE *file = fopen(cachePath, "r");
+
+        if(file==NULL) {
+            return 0;
+        }
+
+        std::string data;
+        char chunk[64 * 1024];
+        size_t in;
+
+        while((in = fread(chunk, 1, sizeof(chunk), file))>0) {
+            data.append(chunk, in);
+        }
+
+        fclose(file);
+
+        try {
+            recordReader r(data.data(), data.size());
+
+            if(memcmp(r.get(sizeof(cacheMagic)), cacheMagic, sizeof(cacheMagic))!=0 ||
+               r.value<unsigned int>()!=cacheVersion) {
+                throw("Not a cache file.");
+            }
+
+            unsigned int count = r.value<unsigned int>();
+
+            for(unsigned int i=0; i<count; ++i) {
+                std::string path = r.string();
+                entry &e = entries[path];
+                e.key = r.value<fileKey>();
+                unsigned int len = r.value<unsigned int>();
+                e.records = std::make_shared<const std::string>(r.get(len), len);
+                e.used = false;
+            }
+        } catch(...) {
+            entries.clear();
+            return 1;
+        }
+
+        return 0;
+    }
+
+    int oaParseCache::save(const char *cachePath)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::string tmpPath = std::string(cachePath) + ".tmp";
+        FILE *file = fopen(tmpPath.c_str(), "w");
+
+        if(file==NULL) {
+            return 1;
+        }
+
+        unsigned int count = entries.size();
+        bool ok = fwrite(cacheMagic, sizeof(cacheMagic), 1, file)==1 &&
+                  fwrite(&cacheVersion, sizeof(cacheVersion), 1, file)==1 &&
+                  fwrite(&count, sizeof(count), 1, file)==1;
+
+        for(std::unordered_map<std::string, entry>::const_iterator it =
+                entries.begin(); ok && it!=entries.end(); ++it) {
+            const std::string &records = *it->second.records;
+            unsigned int len = records.size();
+            ok = fwrite(it->first.c_str(), it->first.size() + 1, 1, file)==1 &&
+                 fwrite(&it->second.key, sizeof(it->second.key), 1, file)==1 &&
+                 fwrite(&len, sizeof(len), 1, file)==1 &&
+                 (len==0 || fwrite(records.data(), len, 1, file)==1);
+        }
+
+        if(fclose(file)!=0 || !ok || rename(tmpPath.c_str(), cachePath)!=0) {
+            remove(tmpPath.c_str());
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void oaParseCache::prune()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+
+        for(std::unordered_map<std::string, entry>::iterator it = entries.begin();
+            it!=entries.end();) {
+            if(it->second.used) {
+                ++it;
+            } else {
+                it = entries.erase(it);
+            }
+        }
+    }
+
+    bool oaParseCache::lookup(const std::string &path, const fileKey &key,
+                              std::shared_ptr<const std::string> &records)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::unordered_map<std::string, entry>::iterator it = entries.find(path);
+
+        if(it==entries.end() || !sameKey(it->second.key, key)) {
+            ++numMisses;
+            return false;
+        }
+
+        ++numHits;
+        it->second.used = true;
+        records = it->second.records;
+        return true;
+    }
+
+    void oaParseCache::store(const std::string &path, const fileKey &key,
+                             const std::shared_ptr<const std::string> &records)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        entry &e = entries[path];
+        e.key = key;
+        e.records = records;
+        e.used = true;
+    }
+
+    int oaParseCache::parse(oaFileParser &parser, const char *filePath)
+    {
+        fileKey key;
+
+        if(!readKey(filePath, key)) {
+            return parser.parse(filePath);
+        }
+
+        std::string path(filePath);
+        std::shared_ptr<const std::string> records;
+
+        if(!lookup(path, key, records)) {
+            cacheRecorder recorder;
+            int status = recorder.parse(filePath);
+            fileKey after;
+            records = std::make_shared<const std::string>(std::move(recorder.records));
+
+            // Only keep results of files that did not change while parsing.
+            if(status==0 && readKey(filePath, after) && sameKey(key, after)) {
+                store(path, key, records);
+            }
+        }
+
+        try {
+            return replay(parser, *records);
+        } catch(...) {
+            parser.onParsedError("Error: paring file.");
+            return 1;
+        }
+    }
+
+    int oaParseCache::replay(oaFileParser &parser, const std::string &records)
+    {
+        oaArena &arena = *parser.arena;
+        recordReader all(records.data(), records.size());
+        int status = 0;
+        arena.reset();
+
+        while(!all.done()) {
+            unsigned char kind = all.value<unsigned char>();
+            unsigned int len = all.value<unsigned int>();
+            // Scalars and strings are read in place; arrays are copied out
+            // so they are aligned and writable.
+            recordReader r(all.get(len), len);
+
+            switch(kind) {
+                case recordPreface: {
+                    unsigned int testBit = r.value<unsigned int>();
+                    unsigned short type = r.value<unsigned short>();
+                    unsigned short schema = r.value<unsigned short>();
+                    unsigned long offset = r.value<unsigned long>();
+                    unsigned int size = r.value<unsigned int>();
+                    unsigned int used = r.value<unsigned int>();
+                    parser.onParsedPreface(testBit, type, schema, offset, size, used);
+                    break;
+                }
+
+                case recordTableInformation: {
+                    unsigned int num = r.value<unsigned int>();
+
+                    if(num>len) {
+                        throw("Cache record is truncated.");
+                    }
+
+                    unsigned long *ids = arena.allocate<unsigned long>(num);
+                    unsigned long *offsets = arena.allocate<unsigned long>(num);
+                    unsigned long *sizes = arena.allocate<unsigned long>(num);
+                    memcpy(ids, r.get(sizeof(ids[0]) * num), sizeof(ids[0]) * num);
+                    memcpy(offsets, r.get(sizeof(offsets[0]) * num), sizeof(offsets[0]) * num);
+                    memcpy(sizes, r.get(sizeof(sizes[0]) * num), sizeof(sizes[0]) * num);
+                    parser.onParsedTableInformation(ids, offsets, sizes, num);
+                    break;
+                }
+
+                case recordFlags:
+                    parser.onParsedFlags(r.value<unsigned int>());
+                    break;
+
+                case recordTimeStamp:
+                    parser.onParsedTimeStamp(r.value<unsigned int>());
+                    break;
+
+                case recordLastSavedTime:
+                    parser.onParsedLastSavedTime(r.value<unsigned long>());
+                    break;
+
+                case recordDatabaseMap: {
+                    unsigned int idCount = r.value<unsigned int>();
+                    unsigned int tblCount = r.value<unsigned int>();
+
+                    if(idCount>len || tblCount>len) {
+                        throw("Cache record is truncated.");
+                    }
+
+                    unsigned long *ids = arena.allocate<unsigned long>(idCount);
+                    unsigned int *types = arena.allocate<unsigned int>(idCount);
+                    unsigned long *tblIds = arena.allocate<unsigned long>(tblCount);
+                    unsigned int *tblTypes = arena.allocate<unsigned int>(tblCount);
+                    memcpy(ids, r.get(sizeof(ids[0]) * idCount), sizeof(ids[0]) * idCount);
+                    memcpy(types, r.get(sizeof(types[0]) * idCount), sizeof(types[0]) * idCount);
+                    memcpy(tblIds, r.get(sizeof(tblIds[0]) * tblCount),
+                           sizeof(tblIds[0]) * tblCount);
+                    memcpy(tblTypes, r.get(sizeof(tblTypes[0]) * tblCount),
+                           sizeof(tblTypes[0]) * tblCount);
+
+                    if(parser.dbMap!=NULL) {
+                        parser.dbMap->assign(ids, types, idCount, tblIds, tblTypes, tblCount);
+                    }
+
+                    parser.onParsedDatabaseMap(ids, types, idCount, tblIds, tblTypes, tblCount);
+                    break;
+                }
+
+                case recordStringTable: {
+                    tableIndex table = r.value<tableIndex>();
+                    const char *buffer = r.get(table.used);
+
+                    if(parser.strings!=NULL) {
+                        parser.strings->build(table, buffer);
+                        parser.onParsedStringTableIndex(*parser.strings);
+                    } else {
+                        parser.onParsedStringTable(table, buffer);
+                    }
+
+                    break;
+                }
+
+                case recordCreateTime:
+                    parser.onParsedCreateTime(r.value<unsigned long>());
+                    break;
+
+                case recordDMandBuildName: {
+                    unsigned short dataModelRev = r.value<unsigned short>();
+                    parser.onParsedDMandBuildName(dataModelRev, r.string());
+                    break;
+                }
+
+                case recordBuildInformation: {
+                    unsigned short appDataModelRev = r.value<unsigned short>();
+                    unsigned short kitDataModelRev = r.value<unsigned short>();
+                    unsigned short appAPIMinorRev = r.value<unsigned short>();
+                    unsigned short kitReleaseNum = r.value<unsigned short>();
+                    const char *appBuildName = r.string();
+                    const char *kitBuildName = r.string();
+                    const char *platforName = r.string();
+                    parser.onParsedBuildInformation(appDataModelRev, kitDataModelRev,
+                                                    appAPIMinorRev, kitReleaseNum, appBuildName, kitBuildName, platforName);
+                    break;
+                }
+
+                case recordDatabaseMapD: {
+                    unsigned long num = r.value<unsigned long>();
+
+                    if(num>len) {
+                        throw("Cache record is truncated.");
+                    }
+
+                    unsigned long *ids = arena.allocate<unsigned long>(num);
+                    unsigned int *types = arena.allocate<unsigned int>(num);
+                    memcpy(ids, r.get(sizeof(ids[0]) * num), sizeof(ids[0]) * num);
+                    memcpy(types, r.get(sizeof(types[0]) * num), sizeof(types[0]) * num);
+
+                    if(parser.dbMap!=NULL) {
+                        parser.dbMap->applyDelta(ids, types, num);
+                    }
+
+                    parser.onParsedDatabaseMapD(ids, types, num);
+                    break;
+                }
+
+                case recordDatabaseMarker:
+                    parser.onParsedDatabaseMarker(r.value<unsigned int>());
+                    break;
+
+                case recordError:
+                    parser.onParsedError(r.string());
+                    status = 1;
+                    break;
+
+                default:
+                    throw("Unknown cache record.");
+            }
+        }
+
+        return status;
+    }
+
+    unsigned long oaParseCache::hits() const
+    {
+        return numHits;
+    }
+
+    unsigned long oaParseCache::misses() const
+    {
+        return numMisses;
+    }
+} //End namespace oafp
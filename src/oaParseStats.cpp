@@ -0,0 +1,234 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaParseStats.h"
+
+#include <cstring>
+
+namespace oafp
+{
+    static int bucket(unsigned long value)
+    {
+        int b = value==0 ? 0 : 63 - __builtin_clzl(value);
+        return b<tableStats::numBuckets ? b : tableStats::numBuckets - 1;
+    }
+
+    static void addCounters(parseCounters &to, const parseCounters &from)
+    {
+        to.parses += from.parses;
+        to.errors += from.errors;
+        to.bytesRead += from.bytesRead;
+        to.reads += from.reads;
+        to.seeks += from.seeks;
+        to.seconds += from.seconds;
+    }
+
+    static void dumpString(FILE *out, const std::string &str)
+    {
+        fputc('"', out);
+
+        for(size_t i=0; i<str.size(); ++i) {
+            unsigned char c = str[i];
+
+            if(c=='"' || c=='\\') {
+                fputc('\\', out);
+                fputc(c, out);
+            } else if(c<0x20) {
+                fprintf(out, "\\u%04x", c);
+            } else {
+                fputc(c, out);
+            }
+        }
+
+        fputc('"', out);
+    }
+
+    static void dumpHistogram(FILE *out, const unsigned long histogram[])
+    {
+        int last = tableStats::numBuckets - 1;
+
+        while(last>0 && histogram[last]==0) {
+            --last;
+        }
+
+        fputc('[', out);
+
+        for(int b=0; b<=last; ++b) {
+            fprintf(out, b==0 ? "%lu" : ",%lu", histogram[b]);
+        }
+
+        fputc(']', out);
+    }
+
+    static void dumpCounters(FILE *out, const parseCounters &c)
+    {
+        fprintf(out, "{\"parses\":%lu,\"errors\":%lu,\"bytesRead\":%lu,"
+                "\"reads\":%lu,\"seeks\":%lu,\"seconds\":%.9f}",
+                c.parses, c.errors, c.bytesRead, c.reads, c.seeks, c.seconds);
+    }
+
+    oaParseStats::oaParseStats()
+    {
+        reset();
+    }
+
+    void oaParseStats::reset()
+    {
+        memset(&lastParse, 0, sizeof(lastParse));
+        memset(&total, 0, sizeof(total));
+        tables.clear();
+        slowest.clear();
+    }
+
+    void oaParseStats::merge(const oaParseStats &other)
+    {
+        addCounters(total, other.total);
+
+        for(std::map<unsigned long, tableStats>::const_iterator it =
+                other.tables.begin(); it!=other.tables.end(); ++it) {
+            std::map<unsigned long, tableStats>::iterator t = tables.find(it->first);
+
+            if(t==tables.end()) {
+                tables[it->first] = it->second;
+                continue;
+            }
+
+            t->second.count += it->second.count;
+            t->second.bytes += it->second.bytes;
+            t->second.seconds += it->second.seconds;
+
+            if(it->second.maxSeconds>t->second.maxSeconds) {
+                t->second.maxSeconds = it->second.maxSeconds;
+            }
+
+            for(int b=0; b<tableStats::numBuckets; ++b) {
+                t->second.latency[b] += it->second.latency[b];
+                t->second.size[b] += it->second.size[b];
+            }
+        }
+
+        for(size_t i=0; i<other.slowest.size(); ++i) {
+            addSlowest(other.slowest[i].first, other.slowest[i].second);
+        }
+    }
+
+    void oaParseStats::beginParse(const char *filePath)
+    {
+        memset(&lastParse, 0, sizeof(lastParse));
+        lastParse.parses = 1;
+        this->filePath = filePath!=NULL ? filePath : "";
+        start = std::chrono::steady_clock::now();
+    }
+
+    void oaParseStats::addRead(unsigned long bytes, bool seek)
+    {
+        lastParse.bytesRead += bytes;
+        lastParse.reads += 1;
+        lastParse.seeks += seek ? 1 : 0;
+    }
+
+    void oaParseStats::addTable(unsigned long id, unsigned long bytes,
+                                double seconds)
+    {
+        std::map<unsigned long, tableStats>::iterator it = tables.find(id);
+
+        if(it==tables.end()) {
+            tableStats t;
+            memset(&t, 0, sizeof(t));
+            it = tables.insert(std::make_pair(id, t)).first;
+        }
+
+        tableStats &t = it->second;
+        t.count += 1;
+        t.bytes += bytes;
+        t.seconds += seconds;
+
+        if(seconds>t.maxSeconds) {
+            t.maxSeconds = seconds;
+        }
+
+        t.latency[bucket((unsigned long)(seconds * 1e9))] += 1;
+        t.size[bucket(bytes)] += 1;
+    }
+
+    void oaParseStats::endParse(int status)
+    {
+        lastParse.errors = status!=0 ? 1 : 0;
+        lastParse.seconds = std::chrono::duration<double>
+                            (std::chrono::steady_clock::now() - start).count();
+        addCounters(total, lastParse);
+        addSlowest(lastParse.seconds, filePath);
+    }
+
+    void oaParseStats::addSlowest(double seconds, const std::string &filePath)
+    {
+        if(slowest.size()==numSlowest && seconds<=slowest.back().first) {
+            return;
+        }
+
+        std::vector<std::pair<double, std::string> >::iterator it = slowest.begin();
+
+        while(it!=slowest.end() && it->first>=seconds) {
+            ++it;
+        }
+
+        slowest.insert(it, std::make_pair(seconds, filePath));
+
+        if(slowest.size()>numSlowest) {
+            slowest.pop_back();
+        }
+    }
+
+    void oaParseStats::dump(FILE *out) const
+    {
+        fprintf(out, "{\"total\":");
+        dumpCounters(out, total);
+        fprintf(out, ",\"lastParse\":");
+        dumpCounters(out, lastParse);
+        fprintf(out, ",\"tables\":[");
+
+        for(std::map<unsigned long, tableStats>::const_iterator it = tables.begin();
+            it!=tables.end(); ++it) {
+            const tableStats &t = it->second;
+            fprintf(out, "%s{\"id\":\"0x%02lx\",\"count\":%lu,\"bytes\":%lu,"
+                    "\"seconds\":%.9f,\"maxSeconds\":%.9f,\"latencyNsLog2\":",
+                    it==tables.begin() ? "" : ",", it->first, t.count, t.bytes, t.seconds,
+                    t.maxSeconds);
+            dumpHistogram(out, t.latency);
+            fprintf(out, ",\"sizeLog2\":");
+            dumpHistogram(out, t.size);
+            fputc('}', out);
+        }
+
+        fprintf(out, "],\"slowest\":[");
+
+        for(size_t i=0; i<slowest.size(); ++i) {
+            fprintf(out, "%s{\"path\":", i==0 ? "" : ",");
+            dumpString(out, slowest[i].second);
+            fprintf(out, ",\"seconds\":%.9f}", slowest[i].first);
+        }
+
+        fprintf(out, "]}\n");
+    }
+} //End namespace oafp
@@ -0,0 +1,303 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OASTATICPARSER_H_
+#define OASTATICPARSER_H_
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "oaArena.h"
+#include "oaFileParser.h"
+#include "oaTableDecoders.h"
+
+namespace oafp
+{
+    // Compile time specialised counterpart of oaFileParser.  Derived only
+    // declares the onParsed* callbacks it cares about, with the same
+    // signatures as in oaFileParser but non-virtual and not overloaded, and
+    // either public or with oaStaticParser<Derived> as a friend.  A callback
+    // that is declared but cannot be reached fails to compile:
+    //
+    //     class buildAudit : public oafp::oaStaticParser<buildAudit> {
+    //     public:
+    //         void onParsedBuildInformation(...);
+    //     };
+    //
+    // Tables without a callback are never read.  The remaining ones are
+    // dispatched through a table of decoders, indexed by table id, that is
+    // built at compile time, so the callbacks can be inlined.
+    template<class Derived>
+    class oaStaticParser
+    {
+    public:
+        int parse(const char *filePath);
+
+    private:
+        typedef void (*decoder)(Derived &handler, char *data, unsigned long tblSize,
+                                oaArena &arena);
+
+        // Every callback has a placeholder here that Derived hides by
+        // declaring the callback, so comparing member pointers tells whether
+        // Derived declares it.  The checks run inside the class so a friend
+        // declaration in Derived applies to them; &T::name only fails when
+        // the callback Derived declares cannot be reached.
+        struct unhandled;
+
+#define OAFP_HANDLER_CHECK(name)                                              \
+        void name(unhandled);                                                 \
+        template<class T>                                                     \
+        static constexpr auto reaches_##name(int)                             \
+            -> decltype((void)&T::name, true) {                               \
+            return true;                                                      \
+        };                                                                    \
+        template<class T>                                                     \
+        static constexpr bool reaches_##name(long) {                          \
+            return false;                                                     \
+        };                                                                    \
+        template<class T>                                                     \
+        static constexpr auto has_##name(int)                                 \
+            -> decltype((void)&T::name, true) {                               \
+            return !std::is_same<decltype(&T::name),                          \
+                                 decltype(&oaStaticParser::name)>::value;     \
+        };                                                                    \
+        template<class T>                                                     \
+        static constexpr bool has_##name(long) {                              \
+            return false;                                                     \
+        };
+
+        OAFP_HANDLER_CHECK(onParsedPreface)
+        OAFP_HANDLER_CHECK(onParsedTableInformation)
+        OAFP_HANDLER_CHECK(onParsedFlags)
+        OAFP_HANDLER_CHECK(onParsedTimeStamp)
+        OAFP_HANDLER_CHECK(onParsedLastSavedTime)
+        OAFP_HANDLER_CHECK(onParsedDatabaseMap)
+        OAFP_HANDLER_CHECK(onParsedStringTable)
+        OAFP_HANDLER_CHECK(onParsedCreateTime)
+        OAFP_HANDLER_CHECK(onParsedDMandBuildName)
+        OAFP_HANDLER_CHECK(onParsedBuildInformation)
+        OAFP_HANDLER_CHECK(onParsedDatabaseMapD)
+        OAFP_HANDLER_CHECK(onParsedDatabaseMarker)
+        OAFP_HANDLER_CHECK(onParsedError)
+
+#undef OAFP_HANDLER_CHECK
+
+        template<unsigned long Id>
+        static constexpr bool handles();
+        template<unsigned long Id>
+        static void decode(Derived &handler, char *data, unsigned long tblSize,
+                           oaArena &arena);
+        template<unsigned long Id>
+        static constexpr decoder decoderFor();
+        template<std::size_t... Ids>
+        static constexpr std::array<decoder, sizeof...(Ids)> makeDispatch(
+            std::index_sequence<Ids...>);
+
+        static constexpr std::size_t numIds = 0x29;
+        static constexpr std::array<decoder, numIds> dispatch = makeDispatch(
+                    std::make_index_sequence<numIds>());
+
+        tableDirectory      dir;
+        oaArena             arena;
+    };
+
+    template<class Derived>
+    template<unsigned long Id>
+    constexpr bool oaStaticParser<Derived>::handles()
+    {
+        switch(Id) {
+            case 0x04: return has_onParsedFlags<Derived>(0);
+            case 0x05: return has_onParsedTimeStamp<Derived>(0);
+            case 0x06: return has_onParsedLastSavedTime<Derived>(0);
+            case 0x07: return has_onParsedDatabaseMap<Derived>(0);
+            case 0x0a: return has_onParsedStringTable<Derived>(0);
+            case 0x19: return has_onParsedCreateTime<Derived>(0);
+            case 0x1c: return has_onParsedDMandBuildName<Derived>(0);
+            case 0x1d: return has_onParsedBuildInformation<Derived>(0);
+            case 0x1f: return has_onParsedDatabaseMapD<Derived>(0);
+            case 0x28: return has_onParsedDatabaseMarker<Derived>(0);
+            default: return false;
+        }
+    }
+
+    template<class Derived>
+    template<unsigned long Id>
+    void oaStaticParser<Derived>::decode(Derived &handler, char *data,
+                                         unsigned long tblSize, oaArena &arena)
+    {
+        if constexpr(Id==0x04) {
+            decode0x04(data, tblSize, [&](auto... args) {
+                handler.onParsedFlags(args...);
+            });
+        } else if constexpr(Id==0x05) {
+            decode0x05(data, tblSize, [&](auto... args) {
+                handler.onParsedTimeStamp(args...);
+            });
+        } else if constexpr(Id==0x06) {
+            decode0x06(data, tblSize, [&](auto... args) {
+                handler.onParsedLastSavedTime(args...);
+            });
+        } else if constexpr(Id==0x07) {
+            decode0x07(data, tblSize, arena, [&](auto... args) {
+                handler.onParsedDatabaseMap(args...);
+            });
+        } else if constexpr(Id==0x0a) {
+            decode0x0a(data, tblSize, [&](tableIndex table, char *buffer,
+            unsigned long bufferSize) {
+                handler.onParsedStringTable(table, buffer);
+            });
+        } else if constexpr(Id==0x19) {
+            decode0x19(data, tblSize, [&](auto... args) {
+                handler.onParsedCreateTime(args...);
+            });
+        } else if constexpr(Id==0x1c) {
+            decode0x1c(data, tblSize, [&](auto... args) {
+                handler.onParsedDMandBuildName(args...);
+            });
+        } else if constexpr(Id==0x1d) {
+            decode0x1d(data, tblSize, [&](auto... args) {
+                handler.onParsedBuildInformation(args...);
+            });
+        } else if constexpr(Id==0x1f) {
+            decode0x1f(data, tblSize, arena, [&](auto... args) {
+                handler.onParsedDatabaseMapD(args...);
+            });
+        } else if constexpr(Id==0x28) {
+            decode0x28(data, tblSize, [&](auto... args) {
+                handler.onParsedDatabaseMarker(args...);
+            });
+        }
+    }
+
+    template<class Derived>
+    template<unsigned long Id>
+    constexpr typename oaStaticParser<Derived>::decoder
+    oaStaticParser<Derived>::decoderFor()
+    {
+        if constexpr(handles<Id>()) {
+            return &oaStaticParser<Derived>::decode<Id>;
+        } else {
+            return nullptr;
+        }
+    }
+
+    template<class Derived>
+    template<std::size_t... Ids>
+    constexpr std::array<typename oaStaticParser<Derived>::decoder, sizeof...(Ids)>
+    oaStaticParser<Derived>::makeDispatch(std::index_sequence<Ids...>)
+    {
+        return {{ decoderFor<Ids>()... }};
+    }
+
+    template<class Derived>
+    int oaStaticParser<Derived>::parse(const char *filePath)
+    {
+        // Derived is complete here, unlike in the class body.
+#define OAFP_HANDLER_ASSERT(name)                                             \
+        static_assert(reaches_##name<Derived>(0),                            \
+                      #name " must be public or visible to oaStaticParser "    \
+                      "as a friend, and not overloaded.");
+
+        OAFP_HANDLER_ASSERT(onParsedPreface)
+        OAFP_HANDLER_ASSERT(onParsedTableInformation)
+        OAFP_HANDLER_ASSERT(onParsedFlags)
+        OAFP_HANDLER_ASSERT(onParsedTimeStamp)
+        OAFP_HANDLER_ASSERT(onParsedLastSavedTime)
+        OAFP_HANDLER_ASSERT(onParsedDatabaseMap)
+        OAFP_HANDLER_ASSERT(onParsedStringTable)
+        OAFP_HANDLER_ASSERT(onParsedCreateTime)
+        OAFP_HANDLER_ASSERT(onParsedDMandBuildName)
+        OAFP_HANDLER_ASSERT(onParsedBuildInformation)
+        OAFP_HANDLER_ASSERT(onParsedDatabaseMapD)
+        OAFP_HANDLER_ASSERT(onParsedDatabaseMarker)
+        OAFP_HANDLER_ASSERT(onParsedError)
+
+#undef OAFP_HANDLER_ASSERT
+
+        Derived &handler = static_cast<Derived &>(*this);
+
+        try {
+            if(dir.open(filePath)!=0) {
+                throw("File path does not exist.");
+            }
+
+            const fileHeader &fh = dir.header;
+
+            if constexpr(has_onParsedPreface<Derived>(0)) {
+                handler.onParsedPreface(fh.testBit, fh.type, fh.schema, fh.offset, fh.size,
+                                        fh.used);
+            }
+
+            if constexpr(has_onParsedTableInformation<Derived>(0)) {
+                handler.onParsedTableInformation(dir.ids, dir.offsets, dir.sizes, fh.used);
+            }
+
+            arena.reset();
+
+            for(unsigned int i=0; i<fh.used; ++i) {
+                unsigned long id = dir.ids[i];
+
+                if(id>=numIds || dispatch[id]==nullptr) {
+                    continue;
+                }
+
+                unsigned long pos = dir.position(i);
+
+                // Checked before the buffer is allocated for it.
+                if(pos>dir.fileSize || dir.sizes[i]>dir.fileSize - pos) {
+                    throw("Table extends past the end of the file.");
+                }
+
+                // One spare byte keeps trailing names terminated.
+                std::size_t mark = arena.mark();
+                char *buffer = arena.allocate<char>(dir.sizes[i] + 1);
+
+                if(dir.read(i, buffer)!=0) {
+                    throw("Table extends past the end of the file.");
+                }
+
+                buffer[dir.sizes[i]] = '\0';
+                dispatch[id](handler, buffer, dir.sizes[i], arena);
+                arena.rewind(mark);
+            }
+
+            dir.close();
+        } catch(...) {
+            dir.close();
+
+            if constexpr(has_onParsedError<Derived>(0)) {
+                handler.onParsedError("Error: paring file.");
+            }
+
+            return 1;
+        }
+
+        return 0;
+    }
+
+} // End namespace oafp
+
+#endif //OASTATICPARSER_H_
@@ -0,0 +1,146 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaStringSearch.h"
+#include "oaFileParser.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace oafp
+{
+    oaStringSearch::oaStringSearch(const std::string &pattern)
+        : pattern(pattern)
+    {
+    }
+
+    // Records the string around pos and returns the offset just past it.
+    static unsigned long matchAt(const char *strings, unsigned long size,
+                                 unsigned long pos, std::vector<unsigned long> &matches)
+    {
+        const char *start = (const char *)memrchr(strings, '\0', pos);
+        const char *end = (const char *)memchr(strings + pos, '\0', size - pos);
+        matches.push_back(start!=NULL ? start + 1 - strings : 0);
+        return end!=NULL ? end + 1 - strings : size;
+    }
+
+    void oaStringSearch::search(const char *strings, unsigned long size,
+                                std::vector<unsigned long> &matches) const
+    {
+        unsigned long len = pattern.size();
+        const char *p = pattern.data();
+        unsigned long i = 0;
+
+        if(len==0) {
+            while(i<size) {
+                i = matchAt(strings, size, i, matches);
+            }
+
+            return;
+        }
+
+#ifdef __SSE2__
+        const __m128i first = _mm_set1_epi8(p[0]);
+        const __m128i last = _mm_set1_epi8(p[len - 1]);
+
+        while(i + len - 1 + 16<=size) {
+            __m128i blockFirst = _mm_loadu_si128((const __m128i *)&strings[i]);
+            __m128i blockLast = _mm_loadu_si128((const __m128i *)&strings[i + len - 1]);
+            unsigned int mask = _mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last)));
+            unsigned long next = i + 16;
+
+            while(mask!=0) {
+                unsigned long pos = i + __builtin_ctz(mask);
+
+                if(len<=2 || memcmp(strings + pos + 1, p + 1, len - 2)==0) {
+                    next = matchAt(strings, size, pos, matches);
+                    break;
+                }
+
+                mask &= mask - 1;
+            }
+
+            i = next;
+        }
+#endif
+
+        while(i + len<=size) {
+            if(strings[i]==p[0] && memcmp(strings + i, p, len)==0) {
+                i = matchAt(strings, size, i, matches);
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    int oaStringSearch::searchFile(const char *filePath,
+                                   std::vector<std::string> &matches) const
+    {
+        tableDirectory dir;
+
+        if(dir.open(filePath)!=0) {
+            return 1;
+        }
+
+        int i = dir.find(0x0a);
+        tableMapping mapping;
+
+        if(i<0) {
+            return 0;
+        }
+
+        if(dir.map(i, mapping)!=0) {
+            return 1;
+        }
+
+        tableIndex table;
+        unsigned int empty;
+
+        if(mapping.size<sizeof(table) + sizeof(empty)) {
+            tableDirectory::unmap(mapping);
+            return 1;
+        }
+
+        memcpy(&table, mapping.data, sizeof(table));
+        const char *strings = mapping.data + sizeof(table) + sizeof(empty);
+        unsigned long size = std::min<unsigned long>(table.used,
+                             mapping.size - sizeof(table) - sizeof(empty));
+        std::vector<unsigned long> found;
+        search(strings, size, found);
+
+        for(size_t m=0; m<found.size(); ++m) {
+            const char *s = strings + found[m];
+            const char *end = (const char *)memchr(s, '\0', strings + size - s);
+            matches.push_back(std::string(s, end!=NULL ? end - s : strings + size - s));
+        }
+
+        tableDirectory::unmap(mapping);
+        return 0;
+    }
+} //End namespace oafp
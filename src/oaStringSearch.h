@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OASTRINGSEARCH_H_
+#define OASTRINGSEARCH_H_
+
+#include <string>
+#include <vector>
+
+namespace oafp
+{
+    // Substring search over the NUL separated strings of string tables
+    // (0x0a).  Blocks of 16 bytes are filtered on the first and last byte
+    // of the pattern with SSE2 and only the candidates are compared in
+    // full.  Each matching string is reported once; an empty pattern
+    // matches every string.
+    class oaStringSearch
+    {
+    public:
+        oaStringSearch(const std::string &pattern);
+
+        // Appends the offsets of the strings that contain the pattern.
+        void search(const char *strings, unsigned long size,
+                    std::vector<unsigned long> &matches) const;
+
+        // Maps only the string table of the file and appends its matching
+        // strings.  A file without a string table has no matches.  Returns
+        // 1 if the file cannot be read.
+        int searchFile(const char *filePath, std::vector<std::string> &matches) const;
+
+    private:
+        std::string         pattern;
+    };
+
+} // End namespace oafp
+
+#endif //OASTRINGSEARCH_H_
@@ -0,0 +1,217 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaStringTable.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace oafp
+{
+    static unsigned int hashString(const char *str, size_t len)
+    {
+        unsigned int hash = 2166136261u;
+
+        for(size_t i=0; i<len; ++i) {
+            hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+        }
+
+        return hash;
+    }
+
+    oaStringTable::oaStringTable()
+        : buffer(NULL), slotMask(0)
+    {
+        memset(&tbl, 0, sizeof(tbl));
+    }
+
+    void oaStringTable::clear()
+    {
+        memset(&tbl, 0, sizeof(tbl));
+        buffer = NULL;
+        starts.clear();
+        slots.clear();
+        slotMask = 0;
+    }
+
+    void oaStringTable::build(const tableIndex &table, const char *buffer)
+    {
+        tbl = table;
+        this->buffer = buffer;
+        indexStrings();
+        slots.clear();
+    }
+
+    // Every NUL below table.used ends a string and starts the next one.
+    // The last entry of starts is the end of the table plus one, so that
+    // length() works for the last string whether it is terminated or not.
+    void oaStringTable::indexStrings()
+    {
+        unsigned int used = tbl.used;
+        unsigned int b = 0;
+        starts.clear();
+
+        if(used==0) {
+            starts.push_back(0);
+            return;
+        }
+
+        starts.push_back(0);
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+
+        for(; b + 16<=used; b += 16) {
+            __m128i chunk = _mm_loadu_si128((const __m128i *)&buffer[b]);
+            unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+
+            while(mask!=0) {
+                starts.push_back(b + __builtin_ctz(mask) + 1);
+                mask &= mask - 1;
+            }
+        }
+
+#endif
+
+        for(; b<used; ++b) {
+            if(buffer[b]=='\0') {
+                starts.push_back(b + 1);
+            }
+        }
+
+        if(buffer[used - 1]!='\0') {
+            starts.push_back(used + 1);
+        }
+    }
+
+    void oaStringTable::hashStrings() const
+    {
+        unsigned int num = count();
+        unsigned int size = 16;
+
+        while(size<num * 2) {
+            size <<= 1;
+        }
+
+        slots.assign(size, 0);
+        slotMask = size - 1;
+
+        for(unsigned int id=0; id<num; ++id) {
+            const char *str = string(id);
+            unsigned int len = length(id);
+            unsigned int s = hashString(str, len) & slotMask;
+
+            // Keep the first of any duplicate strings.
+            while(slots[s]!=0) {
+                unsigned int other = slots[s] - 1;
+
+                if(length(other)==len && memcmp(string(other), str, len)==0) {
+                    break;
+                }
+
+                s = (s + 1) & slotMask;
+            }
+
+            if(slots[s]==0) {
+                slots[s] = id + 1;
+            }
+        }
+    }
+
+    unsigned int oaStringTable::count() const
+    {
+        return starts.empty() ? 0 : starts.size() - 1;
+    }
+
+    const char *oaStringTable::string(unsigned int id) const
+    {
+        return &buffer[starts[id]];
+    }
+
+    unsigned int oaStringTable::length(unsigned int id) const
+    {
+        return starts[id + 1] - starts[id] - 1;
+    }
+
+    unsigned int oaStringTable::offset(unsigned int id) const
+    {
+        return starts[id];
+    }
+
+    int oaStringTable::find(const char *str) const
+    {
+        return find(str, strlen(str));
+    }
+
+    int oaStringTable::find(const char *str, size_t len) const
+    {
+        if(slots.empty()) {
+            hashStrings();
+        }
+
+        unsigned int s = hashString(str, len) & slotMask;
+
+        while(slots[s]!=0) {
+            unsigned int id = slots[s] - 1;
+
+            if(length(id)==len && memcmp(string(id), str, len)==0) {
+                return id;
+            }
+
+            s = (s + 1) & slotMask;
+        }
+
+        return -1;
+    }
+
+    int oaStringTable::findOffset(unsigned int offset) const
+    {
+        unsigned int lo = 0;
+        unsigned int hi = count();
+
+        while(lo<hi) {
+            unsigned int mid = lo + (hi - lo) / 2;
+
+            if(starts[mid]<offset) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        return lo<count() && starts[lo]==offset ? (int)lo : -1;
+    }
+
+    const tableIndex &oaStringTable::table() const
+    {
+        return tbl;
+    }
+
+    const char *oaStringTable::data() const
+    {
+        return buffer;
+    }
+} //End namespace oafp
@@ -0,0 +1,241 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OATABLEDECODERS_H_
+#define OATABLEDECODERS_H_
+
+#include <cstring>
+#include <stdint.h>
+
+#include "oaArena.h"
+#include "oaFileParser.h"
+
+namespace oafp
+{
+    // Decoders for the metadata tables, shared by oaFileParser and
+    // oaStaticParser.  Each one takes the raw bytes of its table and hands
+    // the decoded fields to onParsed; bad counts are thrown as strings.
+
+    inline unsigned long roundAlign8Bit(unsigned long len)
+    {
+        unsigned long rem = len%8;
+        return len + (8 - rem);
+    }
+
+    // Decoders check a table's size before reading fixed fields from it, as
+    // a mapped table is not followed by a spare byte.
+    inline void checkTableSize(unsigned long tblSize, unsigned long needed)
+    {
+        if(tblSize<needed) {
+            throw("Table is too small.");
+        }
+    }
+
+    // Length of the NUL terminated name at name, which has to end within
+    // the size bytes left in its table.
+    inline unsigned long nameLength(const char *name, unsigned long size)
+    {
+        const char *end = (const char *)memchr(name, '\0', size);
+
+        if(end==NULL) {
+            throw("Name is not terminated.");
+        }
+
+        return end - name;
+    }
+
+    // Tables handed over from a mapping are only as aligned as their offset
+    // in the file, so arrays of 8 byte values may need to be copied out.
+    template<typename T>
+    T *alignedArray(char *data, unsigned long num, oaArena &arena)
+    {
+        if(((uintptr_t)data % sizeof(T))==0) {
+            return (T *)data;
+        }
+
+        T *copy = arena.allocate<T>(num);
+        memcpy(copy, data, sizeof(T) * num);
+        return copy;
+    }
+
+    // Index items are stored relative to the 0x01 table, the string table
+    // and the 0x01 table itself at an absolute offset.
+    inline unsigned long tablePosition(unsigned long id, unsigned long offset,
+                                       unsigned long startOffset)
+    {
+        //Non-Index Items; Offset start from 0
+        if(id==0x0a || id==0x01) {
+            return offset;
+        }
+
+        //Index Items; Offset start from startOffset
+        return startOffset + offset;
+    }
+
+    template<typename F>
+    void decode0x04(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned int flags = 0;
+        checkTableSize(tblSize, sizeof(flags));
+        memcpy(&flags, data, sizeof(flags));
+        onParsed(flags);
+    }
+
+    template<typename F>
+    void decode0x05(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned int timeStamp;
+        checkTableSize(tblSize, sizeof(timeStamp));
+        memcpy(&timeStamp, data, sizeof(timeStamp));
+        onParsed(timeStamp);
+    }
+
+    template<typename F>
+    void decode0x06(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned long lsTime;
+        checkTableSize(tblSize, sizeof(lsTime));
+        memcpy(&lsTime, data, sizeof(lsTime));
+        onParsed(lsTime);
+    }
+
+    template<typename F>
+    void decode0x07(char *data, unsigned long tblSize, oaArena &arena,
+                    F onParsed)
+    {
+        unsigned int numRes;
+        unsigned int numData;
+        checkTableSize(tblSize, sizeof(numRes) + sizeof(numData));
+        memcpy(&numRes, data, sizeof(numRes));
+        memcpy(&numData, data + sizeof(numRes), sizeof(numData));
+
+        if(numData<numRes || sizeof(numRes) + sizeof(numData) +
+           (sizeof(unsigned long) + sizeof(unsigned int)) * (unsigned long)numData >
+           tblSize) {
+            throw("Database map exceeds its table size.");
+        }
+
+        unsigned int numOther = numData - numRes;
+        char *b = data + sizeof(numRes) + sizeof(numData);
+        unsigned long *ids = alignedArray<unsigned long>(b, numRes, arena);
+        b += sizeof(ids[0]) * numRes;
+        unsigned int *types = (unsigned int *)b;
+        b += sizeof(types[0]) * numRes;
+        unsigned long *tblIds = alignedArray<unsigned long>(b, numOther, arena);
+        b += sizeof(tblIds[0]) * numOther;
+        unsigned int *tblTypes = (unsigned int *)b;
+        onParsed(ids, types, numRes, tblIds, tblTypes, numOther);
+    }
+
+    template<typename F>
+    void decode0x0a(char *data, unsigned long tblSize, F onParsed)
+    {
+        tableIndex table;
+        unsigned int empty;
+
+        if(tblSize<sizeof(table) + sizeof(empty)) {
+            throw("String table is too small.");
+        }
+
+        memcpy(&table, data, sizeof(table));
+        onParsed(table, data + sizeof(table) + sizeof(empty),
+                 tblSize - sizeof(table) - sizeof(empty));
+    }
+
+    template<typename F>
+    void decode0x19(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned long createTime;
+        checkTableSize(tblSize, sizeof(createTime));
+        memcpy(&createTime, data, sizeof(createTime));
+        onParsed(createTime);
+    }
+
+    template<typename F>
+    void decode0x1c(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned short dataModelRev;
+        checkTableSize(tblSize, sizeof(dataModelRev));
+        nameLength(data + sizeof(dataModelRev),
+                   tblSize - sizeof(dataModelRev));
+        memcpy(&dataModelRev, data, sizeof(dataModelRev));
+        onParsed(dataModelRev, data + sizeof(dataModelRev));
+    }
+
+    template<typename F>
+    void decode0x1d(char *data, unsigned long tblSize, F onParsed)
+    {
+        appInfo ai;
+        checkTableSize(tblSize, sizeof(ai));
+        char *buffer = data + sizeof(ai);
+        unsigned long size = tblSize - sizeof(ai);
+        char *appBuildName;
+        char *kitBuildName;
+        char *platforName;
+        memcpy(&ai, data, sizeof(ai));
+        unsigned long b = 0;
+        appBuildName = &buffer[b];
+        b += roundAlign8Bit(nameLength(appBuildName, size - b));
+        checkTableSize(size, b);
+        kitBuildName = &buffer[b];
+        b += roundAlign8Bit(nameLength(kitBuildName, size - b));
+        checkTableSize(size, b);
+        platforName = &buffer[b];
+        nameLength(platforName, size - b);
+        onParsed(ai.appDataModelRev, ai.kitDataModelRev, ai.appAPIMinorRev,
+                 ai.kitReleaseNum, appBuildName, kitBuildName, platforName);
+    }
+
+    template<typename F>
+    void decode0x1f(char *data, unsigned long tblSize, oaArena &arena,
+                    F onParsed)
+    {
+        unsigned long num;
+        checkTableSize(tblSize, sizeof(num));
+        memcpy(&num, data, sizeof(num));
+
+        if(num > (tblSize - sizeof(num)) /
+           (sizeof(unsigned long) + sizeof(unsigned int))) {
+            throw("Database map delta exceeds its table size.");
+        }
+
+        unsigned long *ids = alignedArray<unsigned long>(data + sizeof(num), num,
+                             arena);
+        unsigned int *types = (unsigned int *)(data + sizeof(num) +
+                                               sizeof(ids[0]) * num);
+        onParsed(ids, types, num);
+    }
+
+    template<typename F>
+    void decode0x28(char *data, unsigned long tblSize, F onParsed)
+    {
+        unsigned int bitCheck;
+        checkTableSize(tblSize, sizeof(bitCheck));
+        memcpy(&bitCheck, data, sizeof(bitCheck));
+        onParsed(bitCheck);
+    }
+
+} // End namespace oafp
+
+#endif //OATABLEDECODERS_H_
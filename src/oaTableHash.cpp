@@ -0,0 +1,136 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "oaTableHash.h"
+
+#include <cstring>
+
+namespace oafp
+{
+    static const unsigned long prime1 = 0x9e3779b185ebca87UL;
+    static const unsigned long prime2 = 0xc2b2ae3d27d4eb4fUL;
+    static const unsigned long prime3 = 0x165667b19e3779f9UL;
+    static const unsigned long prime4 = 0x85ebca77c2b2ae63UL;
+    static const unsigned long prime5 = 0x27d4eb2f165667c5UL;
+
+    static inline unsigned long rotate(unsigned long value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    static inline unsigned long load64(const char *data)
+    {
+        unsigned long value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static inline unsigned long mixLane(unsigned long lane, unsigned long value)
+    {
+        return rotate(lane + value * prime2, 31) * prime1;
+    }
+
+    unsigned long hashBytes(const char *data, unsigned long size,
+                            unsigned long seed)
+    {
+        const char *end = data + size;
+        unsigned long hash;
+
+        if(size>=32) {
+            unsigned long lanes[4] = {seed + prime1 + prime2, seed + prime2, seed,
+                                      seed - prime1
+                                     };
+
+            for(; end - data>=32; data+=32) {
+                lanes[0] = mixLane(lanes[0], load64(data));
+                lanes[1] = mixLane(lanes[1], load64(data + 8));
+                lanes[2] = mixLane(lanes[2], load64(data + 16));
+                lanes[3] = mixLane(lanes[3], load64(data + 24));
+            }
+
+            hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) +
+                   rotate(lanes[3], 18);
+
+            for(int l=0; l<4; ++l) {
+                hash = (hash ^ mixLane(0, lanes[l])) * prime1 + prime4;
+            }
+        } else {
+            hash = seed + prime5;
+        }
+
+        hash += size;
+
+        for(; end - data>=8; data+=8) {
+            hash = rotate(hash ^ mixLane(0, load64(data)), 27) * prime1 + prime4;
+        }
+
+        if(end - data>=4) {
+            unsigned int value;
+            memcpy(&value, data, sizeof(value));
+            hash = rotate(hash ^ (value * prime1), 23) * prime2 + prime3;
+            data += 4;
+        }
+
+        for(; data<end; ++data) {
+            hash = rotate(hash ^ ((unsigned char)*data * prime5), 11) * prime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    int hashTables(const tableDirectory &dir, std::vector<unsigned long> &hashes)
+    {
+        std::vector<char> buffer;
+        hashes.resize(dir.header.used);
+
+        for(unsigned int i=0; i<dir.header.used; ++i) {
+            unsigned long pos = dir.position(i);
+            hashes[i] = 0;
+
+            // 0x01 spans the other tables, which are hashed on their own.
+            if(dir.ids[i]==0x01) {
+                continue;
+            }
+
+            if(pos>dir.fileSize || dir.sizes[i]>dir.fileSize - pos) {
+                return 1;
+            }
+
+            buffer.resize(dir.sizes[i] + 1);
+
+            if(dir.read(i, buffer.data())!=0) {
+                return 1;
+            }
+
+            hashes[i] = hashBytes(buffer.data(), dir.sizes[i]);
+        }
+
+        return 0;
+    }
+} //End namespace oafp
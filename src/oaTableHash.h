@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2017 EDDR Software, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef OATABLEHASH_H_
+#define OATABLEHASH_H_
+
+#include <vector>
+
+#include "oaFileParser.h"
+
+namespace oafp
+{
+    // Fast 64 bit hash of raw bytes, for telling changed tables from
+    // unchanged ones.  It is not cryptographic: 32 byte stripes are folded
+    // into four independent lanes, so it runs at memory speed.
+    unsigned long hashBytes(const char *data, unsigned long size,
+                            unsigned long seed = 0);
+
+    // Hashes every table of the directory, in directory order.  The 0x01
+    // table only spans the others and is left at 0.  Returns 1 if a table
+    // cannot be read or lies outside the file.
+    int hashTables(const tableDirectory &dir, std::vector<unsigned long> &hashes);
+
+} // End namespace oafp
+
+#endif //OATABLEHASH_H_